@@ -0,0 +1,57 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+std::atomic<quint64> s_allocations{0};
+}
+
+quint64 AllocationCounter::count()
+{
+    return s_allocations.load(std::memory_order_relaxed);
+}
+
+void *operator new(std::size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *result = std::malloc(size ? size : 1)) {
+        return result;
+    }
+
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
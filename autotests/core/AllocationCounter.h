@@ -0,0 +1,38 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+/**
+ * Counts the heap allocations made by the test process.
+ * The global operator new is replaced in AllocationCounter.cpp
+ */
+namespace AllocationCounter
+{
+quint64 count();
+
+class Scope
+{
+public:
+    Scope()
+        : m_start(count())
+    {
+    }
+
+    quint64 allocations() const
+    {
+        return count() - m_start;
+    }
+
+private:
+    const quint64 m_start;
+};
+}
+
+#endif /* ALLOCATIONCOUNTER_H */
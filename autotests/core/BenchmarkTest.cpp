@@ -0,0 +1,356 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "BenchmarkTest.h"
+#include "AllocationCounter.h"
+
+#include <common/dbus/common.h>
+#include <common/dbus/org.kde.ActivityManager.Activities.h>
+
+#include <activitiescache_p.h>
+#include <activitiesmodel.h>
+#include <imports/resourceorder.h>
+#include <utils/continue_with.h>
+#include <utils/dbusfuture_p.h>
+
+#include <QDBusAbstractInterface>
+#include <QDBusConnection>
+#include <QDBusInterface>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QString>
+#include <QStringList>
+#include <QTest>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+BenchmarkTest::BenchmarkTest(QObject *parent)
+    : Test(parent)
+{
+    activities.reset(new KActivities::Controller());
+}
+
+void BenchmarkTest::initTestCase()
+{
+    // Waiting for the service to start, and for us to sync
+    TEST_WAIT_UNTIL(activities->serviceStatus() == KActivities::Consumer::Running);
+
+    auto targetActivity = activities->addActivity(QStringLiteral("Benchmark target"));
+    TEST_WAIT_UNTIL(targetActivity.isFinished());
+    target = targetActivity.result();
+
+    auto otherActivity = activities->addActivity(QStringLiteral("Benchmark other"));
+    TEST_WAIT_UNTIL(otherActivity.isFinished());
+    other = otherActivity.result();
+
+    TEST_WAIT_UNTIL(activities->activities().contains(target) && activities->activities().contains(other));
+}
+
+void BenchmarkTest::benchmarkSignalFanOut_data()
+{
+    QTest::addColumn<int>("unrelatedListeners");
+
+    QTest::newRow("no unrelated listeners") << 0;
+    QTest::newRow("1000 unrelated listeners") << 1000;
+    QTest::newRow("10000 unrelated listeners") << 10000;
+}
+
+void BenchmarkTest::benchmarkSignalFanOut()
+{
+    QFETCH(int, unrelatedListeners);
+
+    // The changes are fed into the cache directly, we are measuring
+    // the delivery to the Info instances and not the round-trip to
+    // the service. The number of Info instances for the changed
+    // activity is fixed, while the ones for an unrelated activity
+    // are growing. The cost of a change should stay the same
+    const auto cache = KActivities::ActivitiesCache::self();
+
+    int unrelatedReceived = 0;
+    std::vector<std::unique_ptr<KActivities::Info>> unrelated;
+    unrelated.reserve(unrelatedListeners);
+    for (int i = 0; i < unrelatedListeners; ++i) {
+        unrelated.emplace_back(new KActivities::Info(other));
+        connect(unrelated.back().get(), &KActivities::Info::infoChanged, this, [&unrelatedReceived] {
+            ++unrelatedReceived;
+        });
+        connect(unrelated.back().get(), &KActivities::Info::nameChanged, this, [&unrelatedReceived] {
+            ++unrelatedReceived;
+        });
+    }
+
+    const int subscribers = 10;
+
+    int received = 0;
+    std::vector<std::unique_ptr<KActivities::Info>> subscribed;
+    subscribed.reserve(subscribers);
+    for (int i = 0; i < subscribers; ++i) {
+        subscribed.emplace_back(new KActivities::Info(target));
+        connect(subscribed.back().get(), &KActivities::Info::nameChanged, this, [&received] {
+            ++received;
+        });
+    }
+
+    const auto originalName = subscribed.front()->name();
+
+    const auto rename = [&cache](const QString &id, const QString &name) {
+        QMetaObject::invokeMethod(cache.get(), "setActivityName", Qt::DirectConnection, Q_ARG(QString, id), Q_ARG(QString, name));
+        QMetaObject::invokeMethod(cache.get(), "publishChanges", Qt::DirectConnection);
+    };
+
+    const int rounds = 100;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int round = 0; round < rounds; ++round) {
+        rename(target, QStringLiteral("Benchmark target %1").arg(round));
+    }
+
+    const auto elapsed = timer.nsecsElapsed();
+
+    // Every change has reached the subscribers of the changed
+    // activity, and nobody else
+    QCOMPARE(received, rounds * subscribers);
+    QCOMPARE(unrelatedReceived, 0);
+
+    QTest::setBenchmarkResult(qreal(elapsed) / rounds, QTest::WalltimeNanoseconds);
+
+    // Restoring what the service knows about the activity
+    rename(target, originalName);
+}
+
+void BenchmarkTest::benchmarkReplaceActivities()
+{
+    const int count = 300;
+
+    QStringList added;
+    for (int i = 0; i < count; ++i) {
+        auto activity = activities->addActivity(QStringLiteral("Benchmark activity %1").arg(i));
+        TEST_WAIT_UNTIL(activity.isFinished());
+        added << activity.result();
+    }
+
+    TEST_WAIT_UNTIL(activities->activities().size() >= count);
+
+    KActivities::ActivitiesModel model;
+    QVERIFY(model.rowCount() >= count);
+
+    // Changing the shown states makes the model
+    // rebuild its sorted list of activities
+    bool filtered = false;
+    QBENCHMARK {
+        filtered = !filtered;
+        model.setShownStates(filtered ? QList<KActivities::Info::State>{KActivities::Info::Running, KActivities::Info::Stopped}
+                                       : QList<KActivities::Info::State>{});
+    }
+
+    for (const auto &activity : std::as_const(added)) {
+        auto removed = activities->removeActivity(activity);
+        TEST_WAIT_UNTIL(removed.isFinished());
+    }
+}
+
+void BenchmarkTest::benchmarkInfoConstruction()
+{
+    const int count = 10000;
+
+    QBENCHMARK {
+        std::vector<std::unique_ptr<KActivities::Info>> infos;
+        infos.reserve(count);
+
+        for (int i = 0; i < count; ++i) {
+            infos.emplace_back(new KActivities::Info(target));
+        }
+    }
+}
+
+void BenchmarkTest::benchmarkListActivitiesAllocations()
+{
+    const auto call = QDBusMessage::createMethodCall(KAMD_DBUS_SERVICE,
+                                                     KAMD_DBUS_OBJECT_PATH("Activities"),
+                                                     KAMD_DBUS_OBJECT("Activities"),
+                                                     QStringLiteral("ListActivitiesWithInformation"));
+
+    // The transport is not what we are interested in, only what
+    // happens with the reply once it arrives. It is demarshalled
+    // and moved into the cache, the same way the cache does it
+    // for its own call to the service
+    auto watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(call));
+    watcher->waitForFinished();
+    QVERIFY(!watcher->isError());
+
+    const auto cache = KActivities::ActivitiesCache::self();
+
+    AllocationCounter::Scope allocations;
+    QMetaObject::invokeMethod(cache.get(), "setAllActivitiesFromReply", Qt::DirectConnection, Q_ARG(QDBusPendingCallWatcher *, watcher));
+    QTest::setBenchmarkResult(allocations.allocations(), QTest::Events);
+
+    QVERIFY(cache->snapshot()->activities.contains(target));
+    QVERIFY(cache->snapshot()->activities.contains(other));
+}
+
+void BenchmarkTest::benchmarkFutureAllocations()
+{
+    QDBusInterface service(KAMD_DBUS_SERVICE, KAMD_DBUS_OBJECT_PATH("Activities"), KAMD_DBUS_OBJECT("Activities"));
+
+    const int calls = 100;
+    int finished = 0;
+
+    const auto before = DBusFuture::latencyHistogram();
+
+    // Allocations per call, including the continuation. Apart from
+    // the D-Bus message itself, a call should cost the pending reply
+    // object and the state shared with the future
+    AllocationCounter::Scope allocations;
+
+    for (int i = 0; i < calls; ++i) {
+        kamd::utils::continue_with(DBusFuture::asyncCall<QStringList>(&service, QStringLiteral("ListActivities")),
+                                   [&finished](const std::optional<QStringList> &activities) {
+                                       if (activities.has_value()) {
+                                           ++finished;
+                                       }
+                                   });
+    }
+
+    TEST_WAIT_UNTIL(finished == calls);
+
+    QTest::setBenchmarkResult(qreal(allocations.allocations()) / calls, QTest::Events);
+
+    // Every call has been recorded in the latency histogram
+    const auto after = DBusFuture::latencyHistogram();
+    quint64 recorded = 0;
+    for (int bucket = 0; bucket < DBusFuture::LatencyHistogram::bucketCount; ++bucket) {
+        recorded += after.completed[bucket] - before.completed[bucket];
+        QCOMPARE(after.timedOut[bucket], before.timedOut[bucket]);
+    }
+    QCOMPARE(recorded, quint64(calls));
+
+    // Ready values do not go through the event loop
+    auto ready = DBusFuture::fromValue(QStringLiteral("ready"));
+    QVERIFY(ready.isFinished());
+    QCOMPARE(ready.result(), QStringLiteral("ready"));
+}
+
+void SilentService::Wait()
+{
+    setDelayedReply(true);
+}
+
+namespace
+{
+class SilentInterface : public QDBusAbstractInterface
+{
+public:
+    explicit SilentInterface(const QDBusConnection &silentConnection)
+        : QDBusAbstractInterface(silentConnection.baseService(), QStringLiteral("/Silent"), "org.kde.ActivityManager.Silent", QDBusConnection::sessionBus(), nullptr)
+    {
+    }
+};
+} // namespace
+
+void BenchmarkTest::testCanceledCalls()
+{
+    // The silent service needs its own connection, the calls
+    // to the same connection are not going through the bus
+    auto connection = QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("SilentService"));
+    SilentService silentService;
+    QVERIFY(connection.registerObject(QStringLiteral("/Silent"), &silentService, QDBusConnection::ExportAllSlots));
+
+    SilentInterface service(connection);
+
+    const auto before = DBusFuture::latencyHistogram();
+    const auto pendingBefore = DBusFuture::pendingCalls();
+    bool continued = false;
+
+    QList<QFuture<QString>> futures;
+    for (int i = 0; i < 100; ++i) {
+        auto future = DBusFuture::asyncCallWithTimeout<QString>(&service, 60000, QStringLiteral("Wait"));
+        kamd::utils::continue_with(future, [&continued](const std::optional<QString> &) {
+            continued = true;
+        });
+        futures << future;
+    }
+
+    QCOMPARE(DBusFuture::pendingCalls(), pendingBefore + 100);
+
+    for (auto &future : futures) {
+        future.cancel();
+    }
+
+    // Canceled calls are released without waiting for the replies,
+    // these would not come before the timeout
+    TEST_WAIT_UNTIL((QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete), DBusFuture::pendingCalls() == pendingBefore));
+
+    QVERIFY(!continued);
+
+    // Nothing has been recorded for the canceled calls
+    const auto after = DBusFuture::latencyHistogram();
+    for (int bucket = 0; bucket < DBusFuture::LatencyHistogram::bucketCount; ++bucket) {
+        QCOMPARE(after.completed[bucket], before.completed[bucket]);
+        QCOMPARE(after.timedOut[bucket], before.timedOut[bucket]);
+    }
+
+    connection.unregisterObject(QStringLiteral("/Silent"));
+    QDBusConnection::disconnectFromBus(QStringLiteral("SilentService"));
+}
+
+void BenchmarkTest::benchmarkResourceOrder_data()
+{
+    QTest::addColumn<int>("ordered");
+
+    QTest::newRow("no user order") << 0;
+    QTest::newRow("500 ordered") << 500;
+    QTest::newRow("5000 ordered") << 5000;
+}
+
+void BenchmarkTest::benchmarkResourceOrder()
+{
+    QFETCH(int, ordered);
+
+    // This is what ResourceModel::lessThan does for each comparison
+    // when sorting a favourites list with 5000 linked resources
+    const int count = 5000;
+
+    QStringList resources;
+    resources.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        resources << QStringLiteral("/home/user/Documents/resource-%1.txt").arg(i);
+    }
+
+    auto order = resources;
+    std::shuffle(order.begin(), order.end(), *QRandomGenerator::global());
+    order.resize(ordered);
+
+    const KActivities::Imports::ResourceOrder lessThan(order);
+
+    QBENCHMARK {
+        auto sorted = resources;
+        std::shuffle(sorted.begin(), sorted.end(), *QRandomGenerator::global());
+        std::sort(sorted.begin(), sorted.end(), lessThan);
+    }
+
+    auto sorted = resources;
+    std::sort(sorted.begin(), sorted.end(), lessThan);
+    QCOMPARE(sorted.mid(0, ordered), order);
+}
+
+void BenchmarkTest::cleanupTestCase()
+{
+    auto removeTarget = activities->removeActivity(target);
+    TEST_WAIT_UNTIL(removeTarget.isFinished());
+
+    auto removeOther = activities->removeActivity(other);
+    TEST_WAIT_UNTIL(removeOther.isFinished());
+
+    Q_EMIT testFinished();
+}
+
+#include "moc_BenchmarkTest.cpp"
@@ -0,0 +1,60 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef BENCHMARKTEST_H
+#define BENCHMARKTEST_H
+
+#include <common/test.h>
+
+#include <controller.h>
+
+#include <QDBusContext>
+#include <QScopedPointer>
+
+class BenchmarkTest : public Test
+{
+    Q_OBJECT
+public:
+    BenchmarkTest(QObject *parent = nullptr);
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void benchmarkSignalFanOut_data();
+    void benchmarkSignalFanOut();
+
+    void benchmarkReplaceActivities();
+
+    void benchmarkInfoConstruction();
+
+    void benchmarkListActivitiesAllocations();
+
+    void benchmarkFutureAllocations();
+    void testCanceledCalls();
+
+    void benchmarkResourceOrder_data();
+    void benchmarkResourceOrder();
+
+    void cleanupTestCase();
+
+private:
+    QScopedPointer<KActivities::Controller> activities;
+    QString target;
+    QString other;
+};
+
+// A service that never replies, the calls made to it
+// are pending until they are canceled or time out
+class SilentService : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.ActivityManager.Silent")
+
+public Q_SLOTS:
+    void Wait();
+};
+
+#endif /* BENCHMARKTEST_H */
@@ -0,0 +1,100 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "ReconnectTest.h"
+
+#include <QCoreApplication>
+#include <QString>
+#include <QTest>
+
+KActivities::Consumer *ReconnectSetup::consumer = nullptr;
+QStringList ReconnectSetup::activities;
+QString ReconnectSetup::currentActivity;
+QElapsedTimer ReconnectSetup::restartTimer;
+
+int ReconnectSetup::activitiesAdded = 0;
+int ReconnectSetup::activitiesRemoved = 0;
+int ReconnectSetup::currentActivityChanges = 0;
+QList<KActivities::Consumer::ServiceStatus> ReconnectSetup::statusChanges;
+
+namespace
+{
+int gracePeriod()
+{
+    const auto gracePeriod = QCoreApplication::instance()->property("org.kde.KActivities.core.reconnectGracePeriod");
+    return gracePeriod.isValid() ? gracePeriod.toInt() : 2000;
+}
+} // namespace
+
+ReconnectSetup::ReconnectSetup(QObject *parent)
+    : Test(parent)
+{
+}
+
+void ReconnectSetup::testRecordingSignals()
+{
+    consumer = new KActivities::Consumer(this);
+
+    TEST_WAIT_UNTIL(consumer->serviceStatus() == KActivities::Consumer::Running);
+
+    activities = consumer->activities();
+    currentActivity = consumer->currentActivity();
+    QVERIFY(!activities.isEmpty());
+
+    connect(consumer, &KActivities::Consumer::activityAdded, this, [] {
+        ++activitiesAdded;
+    });
+    connect(consumer, &KActivities::Consumer::activityRemoved, this, [] {
+        ++activitiesRemoved;
+    });
+    connect(consumer, &KActivities::Consumer::currentActivityChanged, this, [] {
+        ++currentActivityChanges;
+    });
+    connect(consumer, &KActivities::Consumer::serviceStatusChanged, this, [](KActivities::Consumer::ServiceStatus status) {
+        statusChanges << status;
+    });
+
+    restartTimer.start();
+}
+
+void ReconnectSetup::cleanupTestCase()
+{
+    Q_EMIT testFinished();
+}
+
+ReconnectTest::ReconnectTest(QObject *parent)
+    : Test(parent)
+{
+}
+
+void ReconnectTest::testRestartWithinGracePeriod()
+{
+    const auto consumer = ReconnectSetup::consumer;
+    QVERIFY(consumer);
+
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(isActivityManagerRunning(), gracePeriod());
+    QVERIFY2(ReconnectSetup::restartTimer.elapsed() < gracePeriod(), "The service took longer than the grace period to restart");
+
+    // Waiting for the grace period to run out, if we failed to
+    // reconnect, the offline defaults would be loaded by now
+    QTest::qWait(gracePeriod() + 500);
+
+    QCOMPARE(ReconnectSetup::activitiesAdded, 0);
+    QCOMPARE(ReconnectSetup::activitiesRemoved, 0);
+    QCOMPARE(ReconnectSetup::currentActivityChanges, 0);
+    QVERIFY(!ReconnectSetup::statusChanges.contains(KActivities::Consumer::NotRunning));
+
+    QCOMPARE(consumer->serviceStatus(), KActivities::Consumer::Running);
+    QCOMPARE(consumer->activities(), ReconnectSetup::activities);
+    QCOMPARE(consumer->currentActivity(), ReconnectSetup::currentActivity);
+}
+
+void ReconnectTest::cleanupTestCase()
+{
+    Q_EMIT testFinished();
+}
+
+#include "moc_ReconnectTest.cpp"
@@ -0,0 +1,57 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef RECONNECTTEST_H
+#define RECONNECTTEST_H
+
+#include <common/test.h>
+
+#include <consumer.h>
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QStringList>
+
+// Connects to the running service and starts recording what
+// the clients are told while the service gets restarted
+class ReconnectSetup : public Test
+{
+    Q_OBJECT
+public:
+    ReconnectSetup(QObject *parent = nullptr);
+
+private Q_SLOTS:
+    void testRecordingSignals();
+
+    void cleanupTestCase();
+
+public:
+    static KActivities::Consumer *consumer;
+    static QStringList activities;
+    static QString currentActivity;
+    static QElapsedTimer restartTimer;
+
+    static int activitiesAdded;
+    static int activitiesRemoved;
+    static int currentActivityChanges;
+    static QList<KActivities::Consumer::ServiceStatus> statusChanges;
+};
+
+// Checks that a service which came back within the grace
+// period was not reported as gone, nor were its activities
+class ReconnectTest : public Test
+{
+    Q_OBJECT
+public:
+    ReconnectTest(QObject *parent = nullptr);
+
+private Q_SLOTS:
+    void testRestartWithinGracePeriod();
+
+    void cleanupTestCase();
+};
+
+#endif /* RECONNECTTEST_H */
@@ -0,0 +1,118 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "SingletonTest.h"
+
+#include <activitiescache_p.h>
+#include <consumer.h>
+#include <info.h>
+#include <manager_p.h>
+
+#include <QAtomicInt>
+#include <QSemaphore>
+#include <QString>
+#include <QTest>
+#include <QThread>
+
+#include <memory>
+#include <vector>
+
+SingletonTest::SingletonTest(QObject *parent)
+    : Test(parent)
+{
+    // Nothing from the library can be used before the test runs,
+    // the point is to have the threads race to create the singletons
+    QCoreApplication::instance()->setProperty("org.kde.KActivities.core.disableAutostart", true);
+}
+
+void SingletonTest::initTestCase()
+{
+}
+
+void SingletonTest::testConsumersFromManyThreads()
+{
+    const int threadCount = 32;
+    const int iterations = 200;
+
+    QAtomicInt failures;
+    QSemaphore ready;
+    QSemaphore go;
+
+    std::vector<std::shared_ptr<KActivities::ActivitiesCache>> caches(threadCount);
+    std::vector<KActivities::Manager *> managers(threadCount);
+
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(QThread::create([&, i] {
+            // All the threads start using the library at the same time
+            ready.release();
+            go.acquire();
+
+            for (int iteration = 0; iteration < iterations; ++iteration) {
+                KActivities::Consumer consumer;
+
+                if (iteration == 0) {
+                    caches[i] = KActivities::ActivitiesCache::self();
+                    managers[i] = KActivities::Manager::self();
+                }
+
+                const auto current = consumer.currentActivity();
+                const auto activities = consumer.activities();
+
+                if (!activities.contains(current)) {
+                    failures.ref();
+                }
+
+                KActivities::Info info(current);
+                Q_UNUSED(info.name());
+            }
+        }));
+    }
+
+    for (const auto &thread : threads) {
+        thread->start();
+    }
+
+    ready.acquire(threadCount);
+    go.release(threadCount);
+
+    // The main thread is blocked while the workers are running,
+    // nothing they do is allowed to wait for it
+    for (const auto &thread : threads) {
+        QVERIFY(thread->wait(30000));
+    }
+
+    QCOMPARE(failures.loadRelaxed(), 0);
+
+    // Every thread got the same instances
+    QVERIFY(caches[0]);
+    QVERIFY(managers[0]);
+
+    for (int i = 1; i < threadCount; ++i) {
+        QCOMPARE(caches[i], caches[0]);
+        QCOMPARE(managers[i], managers[0]);
+    }
+
+    // Both were handed over to the main thread, which
+    // can now finish initializing them
+    QCOMPARE(caches[0]->thread(), QCoreApplication::instance()->thread());
+    QCOMPARE(managers[0]->thread(), QCoreApplication::instance()->thread());
+
+    caches.clear();
+
+    // Letting the objects that were handed over to
+    // the main thread get destroyed
+    QCoreApplication::processEvents();
+}
+
+void SingletonTest::cleanupTestCase()
+{
+    Q_EMIT testFinished();
+}
+
+QTEST_GUILESS_MAIN(SingletonTest)
+
+#include "moc_SingletonTest.cpp"
@@ -0,0 +1,26 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SINGLETONTEST_H
+#define SINGLETONTEST_H
+
+#include <common/test.h>
+
+class SingletonTest : public Test
+{
+    Q_OBJECT
+public:
+    SingletonTest(QObject *parent = nullptr);
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testConsumersFromManyThreads();
+
+    void cleanupTestCase();
+};
+
+#endif /* SINGLETONTEST_H */
@@ -0,0 +1,144 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "ThreadingTest.h"
+
+#include <consumer.h>
+#include <controller.h>
+#include <info.h>
+
+#include <QAtomicInt>
+#include <QString>
+#include <QTest>
+#include <QThread>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+ThreadingTest::ThreadingTest(QObject *parent)
+    : Test(parent)
+{
+}
+
+void ThreadingTest::initTestCase()
+{
+    KActivities::Consumer consumer;
+
+    // Waiting for the service to start, and for us to sync
+    TEST_WAIT_UNTIL(consumer.serviceStatus() == KActivities::Consumer::Running);
+}
+
+void ThreadingTest::testReadingWhileChanging()
+{
+    KActivities::Controller controller;
+
+    const auto targetName = QStringLiteral("Threading target");
+    auto addTarget = controller.addActivity(targetName);
+    TEST_WAIT_UNTIL(addTarget.isFinished());
+    const auto target = addTarget.result();
+    TEST_WAIT_UNTIL(controller.activities().contains(target));
+
+    const int threadCount = 8;
+    const int rounds = 50;
+    const auto lastName = targetName + QStringLiteral(" %1").arg(rounds - 1);
+
+    std::atomic<bool> finished = false;
+    QAtomicInt failures;
+    QAtomicInt notified;
+
+    // The workers keep reading while the main thread is changing the
+    // activities, and they receive the notifications for the Info
+    // instances they own through their own event loops
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(QThread::create([&] {
+            KActivities::Consumer consumer;
+            KActivities::Info info(target);
+
+            bool receivedLast = false;
+            QObject::connect(&info, &KActivities::Info::nameChanged, [&receivedLast, &lastName](const QString &name) {
+                if (name == lastName) {
+                    receivedLast = true;
+                }
+            });
+
+            const auto check = [&] {
+                // The current activity is never removed in this test
+                const auto current = consumer.currentActivity();
+                const auto activities = consumer.activities();
+
+                if (!activities.contains(current) || !activities.contains(target) || !info.name().startsWith(targetName)) {
+                    failures.ref();
+                }
+            };
+
+            while (!finished) {
+                check();
+                QCoreApplication::processEvents();
+            }
+
+            // The notifications posted before we were told
+            // to finish are still waiting for us
+            QCoreApplication::processEvents();
+            check();
+
+            if (receivedLast) {
+                notified.ref();
+            }
+        }));
+    }
+
+    for (const auto &thread : threads) {
+        thread->start();
+    }
+
+    KActivities::Info info(target);
+    bool renamed = false;
+    connect(&info, &KActivities::Info::nameChanged, this, [&renamed, &lastName](const QString &name) {
+        renamed = (name == lastName);
+    });
+
+    QStringList added;
+
+    for (int round = 0; round < rounds; ++round) {
+        auto rename = controller.setActivityName(target, targetName + QStringLiteral(" %1").arg(round));
+        auto add = controller.addActivity(QStringLiteral("Threading extra %1").arg(round));
+
+        TEST_WAIT_UNTIL(rename.isFinished() && add.isFinished());
+        added << add.result();
+    }
+
+    // The notifications for the worker threads are posted
+    // at the same time as the one for this thread
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(renamed, 5000);
+
+    finished = true;
+
+    for (const auto &thread : threads) {
+        QVERIFY(thread->wait(30000));
+    }
+
+    QCOMPARE(failures.loadRelaxed(), 0);
+    QCOMPARE(notified.loadRelaxed(), threadCount);
+
+    for (const auto &activity : std::as_const(added)) {
+        auto removed = controller.removeActivity(activity);
+        TEST_WAIT_UNTIL(removed.isFinished());
+    }
+
+    auto removed = controller.removeActivity(target);
+    TEST_WAIT_UNTIL(removed.isFinished());
+
+    QCoreApplication::processEvents();
+}
+
+void ThreadingTest::cleanupTestCase()
+{
+    Q_EMIT testFinished();
+}
+
+#include "moc_ThreadingTest.cpp"
@@ -0,0 +1,26 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef THREADINGTEST_H
+#define THREADINGTEST_H
+
+#include <common/test.h>
+
+class ThreadingTest : public Test
+{
+    Q_OBJECT
+public:
+    ThreadingTest(QObject *parent = nullptr);
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testReadingWhileChanging();
+
+    void cleanupTestCase();
+};
+
+#endif /* THREADINGTEST_H */
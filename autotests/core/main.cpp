@@ -9,9 +9,12 @@
 
 #include <common/test.h>
 
+#include "BenchmarkTest.h"
 #include "CleanOnlineTest.h"
 #include "OfflineTest.h"
 #include "Process.h"
+#include "ReconnectTest.h"
+#include "ThreadingTest.h"
 
 class TestRunner : public QObject
 {
@@ -86,6 +89,16 @@ int main(int argc, char *argv[])
             << new CleanOnlineTest() << new CleanOnlineSetup()
             << new OnlineTest()
 
+            // Using the library from many threads at once
+            << new ThreadingTest()
+
+            // Measuring the performance while the manager is running
+            << new BenchmarkTest()
+
+            // Restarting the manager within the reconnection grace period
+            << new ReconnectSetup() << Process::exec(Process::Stop)
+            << Process::exec(Process::Start) << new ReconnectTest()
+
             // Starting the manager
             << Process::exec(Process::Stop)
 
@@ -0,0 +1,223 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "ResourceModelTest.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QString>
+#include <QTest>
+
+#include <imports/resourcemetadatacache.h>
+#include <imports/resourcemodel.h>
+
+using KActivities::Imports::ResourceMetadataCache;
+using KActivities::Imports::ResourceModel;
+
+namespace
+{
+const QString firstActivity = QStringLiteral("11111111-1111-1111-1111-111111111111");
+const QString secondActivity = QStringLiteral("22222222-2222-2222-2222-222222222222");
+
+const QString firstAgent = QStringLiteral("org.kde.first");
+const QString secondAgent = QStringLiteral("org.kde.second");
+
+int rowOf(const ResourceModel &model, const QString &resource)
+{
+    for (int row = 0; row < model.rowCount(); ++row) {
+        if (model.index(row, 0).data(ResourceModel::ResourceRole).toString() == resource) {
+            return row;
+        }
+    }
+
+    return -1;
+}
+} // namespace
+
+ResourceModelTest::ResourceModelTest(QObject *parent)
+    : Test(parent)
+{
+    QCoreApplication::instance()->setProperty("org.kde.KActivities.core.disableAutostart", true);
+}
+
+void ResourceModelTest::link(const QString &activity, const QString &agent, const QString &resource)
+{
+    QSqlQuery query(m_database);
+    query.prepare(QStringLiteral("INSERT INTO ResourceLink (usedActivity, initiatingAgent, targettedResource) VALUES (?, ?, ?)"));
+    query.addBindValue(activity);
+    query.addBindValue(agent);
+    query.addBindValue(resource);
+    QVERIFY(query.exec());
+}
+
+void ResourceModelTest::initTestCase()
+{
+    QVERIFY(m_resources.isValid());
+
+    // The model reads the database from the same place the daemon
+    // writes it to, we are creating one with only the table it needs
+    QStandardPaths::setTestModeEnabled(true);
+
+    const QString databaseDir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/kactivitymanagerd/resources/");
+    QVERIFY(QDir().mkpath(databaseDir));
+    QFile::remove(databaseDir + QStringLiteral("database"));
+
+    m_database = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("ResourceModelTest"));
+    m_database.setDatabaseName(databaseDir + QStringLiteral("database"));
+    QVERIFY(m_database.open());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec(QStringLiteral("CREATE TABLE ResourceLink ("
+                                      "usedActivity TEXT, initiatingAgent TEXT, targettedResource TEXT, "
+                                      "PRIMARY KEY(usedActivity, initiatingAgent, targettedResource))")));
+
+    QFile desktopFile(m_resources.filePath(QStringLiteral("launcher.desktop")));
+    QVERIFY(desktopFile.open(QIODevice::WriteOnly));
+    desktopFile.write(
+        "[Desktop Entry]\n"
+        "Type=Application\n"
+        "Name=Launcher\n"
+        "GenericName=Generic Launcher\n"
+        "Icon=launcher-icon\n");
+    desktopFile.close();
+
+    link(firstActivity, firstAgent, m_resources.filePath(QStringLiteral("first.txt")));
+    link(firstActivity, secondAgent, m_resources.filePath(QStringLiteral("second.txt")));
+    link(secondActivity, firstAgent, m_resources.filePath(QStringLiteral("third.txt")));
+    link(QStringLiteral(""), firstAgent, m_resources.filePath(QStringLiteral("launcher.desktop")));
+}
+
+void ResourceModelTest::testLoading()
+{
+    ResourceModel model;
+    model.setShownAgents(QStringLiteral(":any"));
+    model.setShownActivities(QStringLiteral(":any"));
+
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(model.rowCount() == 4, 5000);
+
+    QVERIFY(rowOf(model, m_resources.filePath(QStringLiteral("first.txt"))) != -1);
+    QVERIFY(rowOf(model, m_resources.filePath(QStringLiteral("second.txt"))) != -1);
+    QVERIFY(rowOf(model, m_resources.filePath(QStringLiteral("third.txt"))) != -1);
+    QVERIFY(rowOf(model, m_resources.filePath(QStringLiteral("launcher.desktop"))) != -1);
+}
+
+void ResourceModelTest::testFiltering()
+{
+    ResourceModel model;
+    model.setShownAgents(QStringLiteral(":any"));
+    model.setShownActivities(firstActivity);
+
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(model.rowCount() == 2, 5000);
+
+    model.setShownAgents(firstAgent);
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(model.rowCount() == 1, 5000);
+    QCOMPARE(model.resourceAt(0), m_resources.filePath(QStringLiteral("first.txt")));
+
+    // Globally linked resources are the ones with no activity
+    model.setShownActivities(QStringLiteral(":global"));
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(model.resourceAt(0) == m_resources.filePath(QStringLiteral("launcher.desktop")), 5000);
+    QCOMPARE(model.rowCount(), 1);
+
+    model.setShownActivities(firstActivity + QLatin1Char(',') + secondActivity);
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(model.rowCount() == 2, 5000);
+    QVERIFY(rowOf(model, m_resources.filePath(QStringLiteral("third.txt"))) != -1);
+}
+
+void ResourceModelTest::testLinkNotifications()
+{
+    ResourceModel model;
+    model.setShownAgents(firstAgent);
+    model.setShownActivities(firstActivity);
+
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(model.rowCount() == 1, 5000);
+
+    const auto resource = m_resources.filePath(QStringLiteral("fourth.txt"));
+
+    // The notifications from the service are applied to the
+    // rows directly, without querying the database again
+    QMetaObject::invokeMethod(&model, "onResourceLinkedToActivity", Q_ARG(QString, firstAgent), Q_ARG(QString, resource), Q_ARG(QString, firstActivity));
+    QCOMPARE(model.rowCount(), 2);
+    QVERIFY(rowOf(model, resource) != -1);
+
+    // The links that the model does not show are ignored
+    QMetaObject::invokeMethod(&model, "onResourceLinkedToActivity", Q_ARG(QString, secondAgent), Q_ARG(QString, resource), Q_ARG(QString, firstActivity));
+    QMetaObject::invokeMethod(&model, "onResourceLinkedToActivity", Q_ARG(QString, firstAgent), Q_ARG(QString, resource), Q_ARG(QString, secondActivity));
+    QCOMPARE(model.rowCount(), 2);
+
+    QMetaObject::invokeMethod(&model, "onResourceUnlinkedFromActivity", Q_ARG(QString, firstAgent), Q_ARG(QString, resource), Q_ARG(QString, firstActivity));
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(rowOf(model, resource), -1);
+}
+
+void ResourceModelTest::testIsResourceLinked()
+{
+    ResourceModel model;
+    model.setShownAgents(firstAgent);
+    model.setShownActivities(firstActivity);
+
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(model.rowCount() == 1, 5000);
+
+    // Answered from the rows of the model
+    QVERIFY(model.isResourceLinkedToActivity(m_resources.filePath(QStringLiteral("first.txt"))));
+    QVERIFY(!model.isResourceLinkedToActivity(m_resources.filePath(QStringLiteral("third.txt"))));
+
+    // Answered from the database
+    QVERIFY(model.isResourceLinkedToActivity(firstAgent, m_resources.filePath(QStringLiteral("third.txt")), secondActivity));
+    QVERIFY(model.isResourceLinkedToActivity(secondAgent, m_resources.filePath(QStringLiteral("second.txt")), firstActivity));
+    QVERIFY(!model.isResourceLinkedToActivity(secondAgent, m_resources.filePath(QStringLiteral("second.txt")), secondActivity));
+}
+
+void ResourceModelTest::testMetadata()
+{
+    ResourceModel model;
+    model.setShownAgents(firstAgent);
+    model.setShownActivities(QStringLiteral(":global"));
+
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(model.rowCount() == 1, 5000);
+
+    // Until the file is read, the model shows its name, and
+    // the title from the desktop file afterwards
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(model.displayAt(0) == QLatin1String("Generic Launcher"), 5000);
+    QCOMPARE(model.index(0, 0).data(ResourceModel::DescriptionRole).toString(), QStringLiteral("Launcher"));
+    QCOMPARE(model.index(0, 0).data(Qt::DecorationRole).toString(), QStringLiteral("launcher-icon"));
+}
+
+void ResourceModelTest::testMetadataEviction()
+{
+    // The limit is read when the cache is created, which is
+    // now as no model is alive to keep the previous one
+    QCoreApplication::instance()->setProperty("org.kde.KActivities.imports.metadataCacheSize", 2);
+    const auto cache = ResourceMetadataCache::self();
+    QCoreApplication::instance()->setProperty("org.kde.KActivities.imports.metadataCacheSize", QVariant());
+
+    const auto first = m_resources.filePath(QStringLiteral("first.txt"));
+    const auto second = m_resources.filePath(QStringLiteral("second.txt"));
+    const auto third = m_resources.filePath(QStringLiteral("third.txt"));
+
+    cache->metadata(first);
+    cache->metadata(second);
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(cache->metadata(first).ready && cache->metadata(second).ready, 5000);
+
+    // Using the first one makes the second one the least recently used
+    cache->metadata(first);
+    cache->metadata(third);
+    TEST_WAIT_UNTIL_WITH_TIMEOUT(cache->metadata(third).ready, 5000);
+
+    QVERIFY(cache->metadata(first).ready);
+    QVERIFY(!cache->metadata(second).ready);
+}
+
+void ResourceModelTest::cleanupTestCase()
+{
+    m_database.close();
+    Q_EMIT testFinished();
+}
+
+QTEST_GUILESS_MAIN(ResourceModelTest)
+
+#include "moc_ResourceModelTest.cpp"
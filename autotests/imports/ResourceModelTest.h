@@ -0,0 +1,40 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef RESOURCEMODELTEST_H
+#define RESOURCEMODELTEST_H
+
+#include <common/test.h>
+
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+
+class ResourceModelTest : public Test
+{
+    Q_OBJECT
+public:
+    ResourceModelTest(QObject *parent = nullptr);
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testLoading();
+    void testFiltering();
+    void testLinkNotifications();
+    void testIsResourceLinked();
+    void testMetadata();
+    void testMetadataEviction();
+
+    void cleanupTestCase();
+
+private:
+    void link(const QString &activity, const QString &agent, const QString &resource);
+
+    QTemporaryDir m_resources;
+    QSqlDatabase m_database;
+};
+
+#endif /* RESOURCEMODELTEST_H */
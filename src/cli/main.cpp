@@ -8,6 +8,8 @@
 #include <QDebug>
 #include <QTimer>
 
+#include <optional>
+
 #include <PlasmaActivities/Controller>
 
 #include "utils.h"
@@ -17,57 +19,57 @@
 DEFINE_COMMAND(bare, 0)
 {
     flags.bare = true;
-    return 0;
+    co_return 0;
 }
 
 DEFINE_COMMAND(noBare, 0)
 {
     flags.bare = false;
-    return 0;
+    co_return 0;
 }
 
 DEFINE_COMMAND(color, 0)
 {
     flags.color = true;
-    return 0;
+    co_return 0;
 }
 
 DEFINE_COMMAND(noColor, 0)
 {
     flags.color = false;
-    return 0;
+    co_return 0;
 }
 
 // Activity management
 
 DEFINE_COMMAND(createActivity, 1)
 {
-    auto result = awaitFuture(controller->addActivity(args(1)));
+    const auto result = co_await controller->addActivity(args(1));
 
-    qDebug().noquote() << result;
+    qDebug().noquote() << result.value_or(QString());
 
-    return 1;
+    co_return 1;
 }
 
 DEFINE_COMMAND(removeActivity, 1)
 {
-    awaitFuture(controller->removeActivity(args(1)));
+    co_await controller->removeActivity(args(1));
 
-    return 1;
+    co_return 1;
 }
 
 DEFINE_COMMAND(startActivity, 1)
 {
-    awaitFuture(controller->startActivity(args(1)));
+    co_await controller->startActivity(args(1));
 
-    return 1;
+    co_return 1;
 }
 
 DEFINE_COMMAND(stopActivity, 1)
 {
-    awaitFuture(controller->stopActivity(args(1)));
+    co_await controller->stopActivity(args(1));
 
-    return 1;
+    co_return 1;
 }
 
 DEFINE_COMMAND(listActivities, 0)
@@ -76,14 +78,14 @@ DEFINE_COMMAND(listActivities, 0)
         printActivity(activity);
     }
 
-    return 0;
+    co_return 0;
 }
 
 DEFINE_COMMAND(currentActivity, 0)
 {
     printActivity(controller->currentActivity());
 
-    return 0;
+    co_return 0;
 }
 
 DEFINE_COMMAND(setActivityProperty, 3)
@@ -93,7 +95,7 @@ DEFINE_COMMAND(setActivityProperty, 3)
     const auto value = args(3);
 
     // clang-format off
-    awaitFuture(
+    co_await (
         what == QLatin1String("name")        ? controller->setActivityName(id, value) :
         what == QLatin1String("description") ? controller->setActivityDescription(id, value) :
         what == QLatin1String("icon")        ? controller->setActivityIcon(id, value) :
@@ -101,7 +103,7 @@ DEFINE_COMMAND(setActivityProperty, 3)
         );
     // clang-format on
 
-    return 3;
+    co_return 3;
 }
 
 DEFINE_COMMAND(activityProperty, 2)
@@ -109,7 +111,8 @@ DEFINE_COMMAND(activityProperty, 2)
     const auto what = args(1);
     const auto id = args(2);
 
-    KActivities::Info info(id);
+    const auto activity = KActivities::Info::shared(id);
+    const KActivities::Info &info = *activity;
     // clang-format off
     out << (
         what == QLatin1String("name")        ? info.name() :
@@ -118,28 +121,28 @@ DEFINE_COMMAND(activityProperty, 2)
                                 QString()
         ) << "\n";
     // clang-format on
-    return 2;
+    co_return 2;
 }
 
 // Activity switching
 
 DEFINE_COMMAND(setCurrentActivity, 1)
 {
-    switchToActivity(args(1));
+    co_await switchToActivity(args(1));
 
-    return 1;
+    co_return 1;
 }
 
 DEFINE_COMMAND(nextActivity, 0)
 {
     controller->nextActivity();
-    return 0;
+    co_return 0;
 }
 
 DEFINE_COMMAND(previousActivity, 0)
 {
     controller->previousActivity();
-    return 0;
+    co_return 0;
 }
 
 void printHelp()
@@ -182,66 +185,75 @@ void printHelp()
     }
 }
 
-int main(int argc, char *argv[])
+kamd::utils::Task<> run()
 {
-    QCoreApplication app(argc, argv);
+    const auto args = QCoreApplication::arguments();
 
-    QTimer::singleShot(0, &app, [] {
-        const auto args = QCoreApplication::arguments();
+    controller = new KActivities::Controller();
 
-        controller = new KActivities::Controller();
+    co_await kamd::utils::when(controller, &KActivities::Controller::serviceStatusChanged, [] {
+        return controller->serviceStatus() == KActivities::Controller::Running;
+    });
 
-        while (controller->serviceStatus() != KActivities::Controller::Running) {
-            QCoreApplication::processEvents();
+// clang-format off
+    #define MATCH_COMMAND(Command)                                             \
+        else if (args[argId] == QLatin1String("--") + toDashes(QStringLiteral(#Command))) \
+        {                                                                      \
+            argId += 1 + co_await Command##_command({ args, argId })();        \
         }
+    // clang-format on
+    if (args.count() <= 1) {
+        printHelp();
 
-// clang-format off
-        #define MATCH_COMMAND(Command)                                         \
-            else if (args[argId] == QLatin1String("--") + toDashes(QStringLiteral(#Command))) \
-            {                                                                  \
-                argId += 1 + Command##_command({ args, argId })();             \
+    } else {
+        for (int argId = 1; argId < args.count();) {
+            if (args[argId] == QLatin1String("--help")) {
+                printHelp();
+                argId++;
             }
-        // clang-format on
-        if (args.count() <= 1) {
-            printHelp();
-
-        } else {
-            for (int argId = 1; argId < args.count();) {
-                if (args[argId] == QLatin1String("--help")) {
-                    printHelp();
-                    argId++;
-                }
-
-                MATCH_COMMAND(bare)
-                MATCH_COMMAND(noBare)
-                MATCH_COMMAND(color)
-                MATCH_COMMAND(noColor)
-
-                MATCH_COMMAND(listActivities)
-
-                MATCH_COMMAND(currentActivity)
-                MATCH_COMMAND(setCurrentActivity)
-                MATCH_COMMAND(activityProperty)
-                MATCH_COMMAND(setActivityProperty)
-                MATCH_COMMAND(nextActivity)
-                MATCH_COMMAND(previousActivity)
-
-                MATCH_COMMAND(createActivity)
-                MATCH_COMMAND(removeActivity)
-                MATCH_COMMAND(startActivity)
-                MATCH_COMMAND(stopActivity)
-
-                else
-                {
-                    qDebug() << "Skipping unknown argument" << args[argId];
-                    argId++;
-                }
+
+            MATCH_COMMAND(bare)
+            MATCH_COMMAND(noBare)
+            MATCH_COMMAND(color)
+            MATCH_COMMAND(noColor)
+
+            MATCH_COMMAND(listActivities)
+
+            MATCH_COMMAND(currentActivity)
+            MATCH_COMMAND(setCurrentActivity)
+            MATCH_COMMAND(activityProperty)
+            MATCH_COMMAND(setActivityProperty)
+            MATCH_COMMAND(nextActivity)
+            MATCH_COMMAND(previousActivity)
+
+            MATCH_COMMAND(createActivity)
+            MATCH_COMMAND(removeActivity)
+            MATCH_COMMAND(startActivity)
+            MATCH_COMMAND(stopActivity)
+
+            else
+            {
+                qDebug() << "Skipping unknown argument" << args[argId];
+                argId++;
             }
         }
+    }
+
+    delete controller;
+
+    QCoreApplication::quit();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
 
-        delete controller;
+    // The commands are awaited by the task, which is resumed
+    // from the event loop whenever a reply from the service arrives
+    std::optional<kamd::utils::Task<>> task;
 
-        QCoreApplication::quit();
+    QTimer::singleShot(0, &app, [&task] {
+        task.emplace(run());
     });
 
     return app.exec();
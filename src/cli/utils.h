@@ -7,6 +7,8 @@
 #ifndef KACTIVITIES_UTILS_H
 #define KACTIVITIES_UTILS_H
 
+#include "utils/task.h"
+
 QTextStream out(stdout);
 
 class StringListView
@@ -73,7 +75,8 @@ void printActivity(const QString &id)
 
     } else {
         using namespace KActivities;
-        Info info(id);
+        const auto activity = Info::shared(id);
+        const Info &info = *activity;
 
         out
             << (
@@ -108,29 +111,12 @@ void printActivity(const QString &id)
     // clang-format on
 }
 
-template<typename T>
-T awaitFuture(const QFuture<T> &future)
-{
-    while (!future.isFinished()) {
-        QCoreApplication::processEvents();
-    }
-
-    return future.result();
-}
-
-void awaitFuture(const QFuture<void> &future)
-{
-    while (!future.isFinished()) {
-        QCoreApplication::processEvents();
-    }
-}
-
-void switchToActivity(const QString &id)
+kamd::utils::Task<> switchToActivity(const QString &id)
 {
-    auto result = awaitFuture(controller->setCurrentActivity(id));
+    const auto result = co_await controller->setCurrentActivity(id);
 
     if (!flags.bare) {
-        if (result) {
+        if (result.value_or(false)) {
             qDebug() << "Current activity is" << id;
         } else {
             qDebug() << "Failed to change the activity";
@@ -150,10 +136,10 @@ void switchToActivity(const QString &id)
             }                                                                  \
         }                                                                      \
                                                                                \
-        int operator()();                                                      \
+        kamd::utils::Task<int> operator()();                                   \
     };                                                                         \
                                                                                \
-    int Command##_command::operator()()
+    kamd::utils::Task<int> Command##_command::operator()()
 
 #endif
 // clang-format on
\ No newline at end of file
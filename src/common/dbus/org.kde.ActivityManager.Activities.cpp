@@ -27,7 +27,7 @@ ActivityInfoStaticInit ActivityInfoStaticInit::_instance;
 
 } // namespace details
 
-QDBusArgument &operator<<(QDBusArgument &arg, const ActivityInfo r)
+QDBusArgument &operator<<(QDBusArgument &arg, const ActivityInfo &r)
 {
     arg.beginStructure();
 
@@ -57,6 +57,20 @@ const QDBusArgument &operator>>(const QDBusArgument &arg, ActivityInfo &r)
     return arg;
 }
 
+const QDBusArgument &operator>>(const QDBusArgument &arg, ActivityInfoList &list)
+{
+    arg.beginArray();
+
+    list.clear();
+    while (!arg.atEnd()) {
+        arg >> list.emplace_back();
+    }
+
+    arg.endArray();
+
+    return arg;
+}
+
 QDebug operator<<(QDebug dbg, const ActivityInfo &r)
 {
     dbg << "ActivityInfo(" << r.id << r.name << ")";
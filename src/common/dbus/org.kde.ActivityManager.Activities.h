@@ -12,6 +12,8 @@
 #include <QList>
 #include <QString>
 
+#include <utility>
+
 struct ActivityInfo {
     QString id;
     QString name;
@@ -19,15 +21,11 @@ struct ActivityInfo {
     QString icon;
     int state;
 
-    ActivityInfo(const QString &id = QString(),
-                 const QString &name = QString(),
-                 const QString &description = QString(),
-                 const QString &icon = QString(),
-                 int state = 0)
-        : id(id)
-        , name(name)
-        , description(description)
-        , icon(icon)
+    ActivityInfo(QString id = QString(), QString name = QString(), QString description = QString(), QString icon = QString(), int state = 0)
+        : id(std::move(id))
+        , name(std::move(name))
+        , description(std::move(description))
+        , icon(std::move(icon))
         , state(state)
     {
     }
@@ -38,9 +36,13 @@ typedef QList<ActivityInfo> ActivityInfoList;
 Q_DECLARE_METATYPE(ActivityInfo)
 Q_DECLARE_METATYPE(ActivityInfoList)
 
-QDBusArgument &operator<<(QDBusArgument &arg, const ActivityInfo);
+QDBusArgument &operator<<(QDBusArgument &arg, const ActivityInfo &rec);
 const QDBusArgument &operator>>(const QDBusArgument &arg, ActivityInfo &rec);
 
+// Demarshalls the records directly into the list, instead of
+// going through a temporary like the generic QList operator does
+const QDBusArgument &operator>>(const QDBusArgument &arg, ActivityInfoList &list);
+
 QDebug operator<<(QDebug dbg, const ActivityInfo &r);
 
 #endif // KAMD_ORG_KDE_ACTIVITYMANAGER_ACTIVITIES_H
@@ -46,8 +46,13 @@ void ActivityInfo::setIdInternal(const QString &id)
 {
     using namespace KActivities;
 
-    // We are killing the old info object, if any
-    m_info.reset(new KActivities::Info(id));
+    // We are releasing the old info object, if any. Since it is
+    // shared with others, we need to disconnect from it
+    if (m_info) {
+        disconnect(m_info.get(), nullptr, this, nullptr);
+    }
+
+    m_info = Info::shared(id);
 
     auto ptr = m_info.get();
 
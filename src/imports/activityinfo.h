@@ -87,7 +87,7 @@ private:
     void setIdInternal(const QString &id);
 
     KActivities::Controller m_service;
-    std::unique_ptr<KActivities::Info> m_info;
+    std::shared_ptr<KActivities::Info> m_info;
     bool m_showCurrentActivity;
 };
 
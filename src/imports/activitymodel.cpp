@@ -23,7 +23,9 @@
 #include <KConfigGroup>
 #include <KDirWatch>
 
-// Boost
+// STL and Boost
+#include <utility>
+
 #include <boost/optional.hpp>
 #include <boost/range/adaptor/filtered.hpp>
 #include <boost/range/algorithm/binary_search.hpp>
@@ -79,31 +81,6 @@ public:
         return (position != container.end()) ? ActivityPosition(std::make_pair(position - container.begin(), position)) : ActivityPosition();
     }
 
-    /**
-     * Notifies the model that an activity was updated
-     */
-    template<typename _Model, typename _Container>
-    static inline void emitActivityUpdated(_Model *model, const _Container &container, QObject *activityInfo, int role)
-    {
-        const auto activity = static_cast<Info *>(activityInfo);
-        emitActivityUpdated(model, container, activity->id(), role);
-    }
-
-    /**
-     * Notifies the model that an activity was updated
-     */
-    template<typename _Model, typename _Container>
-    static inline void emitActivityUpdated(_Model *model, const _Container &container, const QString &activity, int role)
-    {
-        auto position = Private::activityPosition(container, activity);
-
-        if (position) {
-            Q_EMIT model->dataChanged(model->index(position->first),
-                                      model->index(position->first),
-                                      role == Qt::DecorationRole ? QList<int>{role, ActivityModel::ActivityIcon} : QList<int>{role});
-        }
-    }
-
     class BackgroundCache
     {
     public:
@@ -241,7 +218,13 @@ public:
 
 ActivityModel::ActivityModel(QObject *parent)
     : QAbstractListModel(parent)
+    , m_knownActivities(InfoPtrComparator{&m_sortedNames})
+    , m_shownActivities(InfoPtrComparator{&m_sortedNames})
 {
+    m_updatesTimer.setSingleShot(true);
+    m_updatesTimer.setInterval(0);
+    connect(&m_updatesTimer, &QTimer::timeout, this, &ActivityModel::publishUpdates);
+
     // Initializing role names for qml
     connect(&m_service, &Consumer::serviceStatusChanged, this, &ActivityModel::setServiceStatus);
 
@@ -283,15 +266,33 @@ void ActivityModel::replaceActivities(const QStringList &activities)
 {
     // qDebug() << m_shownStatesString << "New list of activities: "
     //          << activities;
-    // qDebug() << m_shownStatesString << " -- RESET MODEL -- ";
 
-    Private::model_reset m(this);
+    // A reset would make QML recreate all the delegates, so
+    // we only add, remove and move the rows that need it
+    const QSet<QString> newActivities(activities.cbegin(), activities.cend());
 
-    m_knownActivities.clear();
-    m_shownActivities.clear();
+    QStringList removedActivities;
+    for (const auto &info : m_knownActivities) {
+        if (!newActivities.contains(info->id())) {
+            removedActivities << info->id();
+        }
+    }
 
-    for (const QString &activity : activities) {
-        onActivityAdded(activity, false);
+    for (const auto &id : std::as_const(removedActivities)) {
+        onActivityRemoved(id);
+    }
+
+    for (const QString &id : activities) {
+        const auto info = registerActivity(id);
+
+        if (Private::matchingState(info, m_shownStates)) {
+            // The service status changes before the rename
+            // notifications for the same update arrive
+            repositionActivity(info);
+            showActivity(info, true);
+        } else {
+            hideActivity(id);
+        }
     }
 }
 
@@ -318,7 +319,7 @@ void ActivityModel::onCurrentActivityChanged(const QString &id)
     Q_UNUSED(id);
 
     for (const auto &activity : m_shownActivities) {
-        Private::emitActivityUpdated(this, m_shownActivities, activity->id(), ActivityCurrent);
+        scheduleUpdate(activity->id(), {ActivityCurrent});
     }
 }
 
@@ -333,7 +334,7 @@ ActivityModel::InfoPtr ActivityModel::registerActivity(const QString &id)
         return *(position->second);
 
     } else {
-        auto activityInfo = std::make_shared<Info>(id);
+        auto activityInfo = Info::shared(id);
 
         auto ptr = activityInfo.get();
 
@@ -342,6 +343,7 @@ ActivityModel::InfoPtr ActivityModel::registerActivity(const QString &id)
         connect(ptr, &Info::iconChanged, this, &ActivityModel::onActivityIconChanged);
         connect(ptr, &Info::stateChanged, this, &ActivityModel::onActivityStateChanged);
 
+        m_sortedNames[id] = activityInfo->name();
         m_knownActivities.insert(InfoPtr(activityInfo));
 
         return activityInfo;
@@ -356,11 +358,13 @@ void ActivityModel::unregisterActivity(const QString &id)
 
     if (position) {
         if (auto shown = Private::activityPosition(m_shownActivities, id)) {
-            Private::model_remove(this, QModelIndex(), shown->first, shown->first);
+            Private::model_remove m(this, QModelIndex(), shown->first, shown->first);
             m_shownActivities.erase(shown->second);
         }
 
+        disconnect(position->second->get(), nullptr, this, nullptr);
         m_knownActivities.erase(position->second);
+        m_sortedNames.remove(id);
     }
 }
 
@@ -371,11 +375,6 @@ void ActivityModel::showActivity(InfoPtr activityInfo, bool notifyClients)
         return;
     }
 
-    // Is it already shown?
-    if (boost::binary_search(m_shownActivities, activityInfo, InfoPtrComparator())) {
-        return;
-    }
-
     auto registeredPosition = Private::activityPosition(m_knownActivities, activityInfo->id());
 
     if (!registeredPosition) {
@@ -385,17 +384,72 @@ void ActivityModel::showActivity(InfoPtr activityInfo, bool notifyClients)
 
     auto activityInfoPtr = *(registeredPosition->second);
 
+    // Is it already shown?
+    const auto position = m_shownActivities.lower_bound(activityInfoPtr);
+
+    if (position != m_shownActivities.end() && *position == activityInfoPtr) {
+        return;
+    }
+
     // qDebug() << m_shownStatesString << "Setting activity visibility to true:"
     //     << activityInfoPtr->id() << activityInfoPtr->name();
 
-    auto position = m_shownActivities.insert(activityInfoPtr);
+    if (!notifyClients) {
+        m_shownActivities.insert(position, activityInfoPtr);
+        return;
+    }
+
+    const unsigned int index = position - m_shownActivities.begin();
+
+    // qDebug() << m_shownStatesString << " -- MODEL INSERT -- " << index;
+    Private::model_insert m(this, QModelIndex(), index, index);
+    m_shownActivities.insert(position, activityInfoPtr);
+}
+
+void ActivityModel::repositionActivity(const InfoPtr &activityInfo)
+{
+    const auto id = activityInfo->id();
+    const auto name = activityInfo->name();
+
+    auto known = Private::activityPosition(m_knownActivities, id);
 
-    if (notifyClients) {
-        unsigned int index = (position.second ? position.first : m_shownActivities.end()) - m_shownActivities.begin();
+    if (!known || m_sortedNames.value(id) == name) {
+        return;
+    }
+
+    // Both sets are sorted by the recorded names, with the new name
+    // recorded, the renamed activity is the only one out of place
+    m_sortedNames[id] = name;
+
+    m_knownActivities.erase(known->second);
+    m_knownActivities.insert(activityInfo);
+
+    auto position = Private::activityPosition(m_shownActivities, id);
+
+    if (!position) {
+        return;
+    }
+
+    // Looking for the new position among the other activities,
+    // on both sides of the current one
+    const int oldRow = position->first;
+    const auto begin = m_shownActivities.begin();
+    const auto end = m_shownActivities.end();
+    const auto lessThan = m_shownActivities.value_comp();
 
-        // qDebug() << m_shownStatesString << " -- MODEL INSERT -- " << index;
-        Private::model_insert(this, QModelIndex(), index, index);
+    int newRow = std::lower_bound(begin, begin + oldRow, activityInfo, lessThan) - begin;
+    if (newRow == oldRow) {
+        newRow = std::lower_bound(begin + oldRow + 1, end, activityInfo, lessThan) - begin - 1;
     }
+
+    if (newRow == oldRow) {
+        return;
+    }
+
+    beginMoveRows(QModelIndex(), oldRow, oldRow, QModelIndex(), newRow > oldRow ? newRow + 1 : newRow);
+    m_shownActivities.erase(position->second);
+    m_shownActivities.insert(activityInfo);
+    endMoveRows();
 }
 
 void ActivityModel::hideActivity(const QString &id)
@@ -408,28 +462,41 @@ void ActivityModel::hideActivity(const QString &id)
     if (position) {
         // qDebug() << m_shownStatesString << " -- MODEL REMOVE -- "
         //          << position->first;
-        Private::model_remove(this, QModelIndex(), position->first, position->first);
+        Private::model_remove m(this, QModelIndex(), position->first, position->first);
         m_shownActivities.erase(position->second);
     }
 }
 // clang-format off
-#define CREATE_SIGNAL_EMITTER(What,Role)                                      \
+#define CREATE_SIGNAL_EMITTER(What,...)                                       \
     void ActivityModel::onActivity##What##Changed(const QString &)             \
     {                                                                          \
-        Private::emitActivityUpdated(this, m_shownActivities, sender(), Role); \
+        scheduleUpdate(static_cast<Info *>(sender())->id(), {__VA_ARGS__});    \
     }
 // clang-format on
 
-CREATE_SIGNAL_EMITTER(Name, Qt::DisplayRole)
 CREATE_SIGNAL_EMITTER(Description, ActivityDescription)
-CREATE_SIGNAL_EMITTER(Icon, Qt::DecorationRole)
+CREATE_SIGNAL_EMITTER(Icon, Qt::DecorationRole, ActivityIcon)
 
 #undef CREATE_SIGNAL_EMITTER
 
+void ActivityModel::onActivityNameChanged(const QString &)
+{
+    auto info = findActivity(sender());
+
+    if (!info) {
+        return;
+    }
+
+    // The rows are sorted by name
+    repositionActivity(info);
+
+    scheduleUpdate(info->id(), {Qt::DisplayRole});
+}
+
 void ActivityModel::onActivityStateChanged(Info::State state)
 {
     if (m_shownStates.empty()) {
-        Private::emitActivityUpdated(this, m_shownActivities, sender(), ActivityState);
+        scheduleUpdate(static_cast<Info *>(sender())->id(), {ActivityState});
 
     } else {
         auto info = findActivity(sender());
@@ -449,10 +516,44 @@ void ActivityModel::onActivityStateChanged(Info::State state)
 void ActivityModel::backgroundsUpdated(const QStringList &activities)
 {
     for (const auto &activity : activities) {
-        Private::emitActivityUpdated(this, m_shownActivities, activity, ActivityBackground);
+        scheduleUpdate(activity, {ActivityBackground});
+    }
+}
+
+void ActivityModel::scheduleUpdate(const QString &id, const QList<int> &roles)
+{
+    m_pendingUpdates.insert(id);
+    for (const int role : roles) {
+        m_pendingRoles.insert(role);
+    }
+
+    if (!m_updatesTimer.isActive()) {
+        m_updatesTimer.start();
     }
 }
 
+void ActivityModel::publishUpdates()
+{
+    const auto updates = std::exchange(m_pendingUpdates, {});
+    const auto roles = std::exchange(m_pendingRoles, {});
+
+    int firstRow = m_shownActivities.size();
+    int lastRow = -1;
+
+    for (const auto &id : updates) {
+        if (auto position = Private::activityPosition(m_shownActivities, id)) {
+            firstRow = qMin(firstRow, int(position->first));
+            lastRow = qMax(lastRow, int(position->first));
+        }
+    }
+
+    if (lastRow < 0) {
+        return;
+    }
+
+    Q_EMIT dataChanged(index(firstRow), index(lastRow), QList<int>(roles.cbegin(), roles.cend()));
+}
+
 void ActivityModel::setShownStates(const QString &states)
 {
     m_shownStates.clear();
@@ -557,7 +658,8 @@ ActivityModel::InfoPtr ActivityModel::findActivity(QObject *ptr) const
     void ActivityModel::setActivity##What(                                     \
         const QString &id, const QString &value, const QJSValue &callback)     \
     {                                                                          \
-        continue_with(m_service.setActivity##What(id, value), callback);       \
+        continue_with(m_service.setActivity##What(id, value),                  \
+                      this, callback);                                         \
     }
 // clang-format on
 
@@ -570,31 +672,31 @@ CREATE_SETTER(Icon)
 // QFuture<bool> Controller::setCurrentActivity(id)
 void ActivityModel::setCurrentActivity(const QString &id, const QJSValue &callback)
 {
-    continue_with(m_service.setCurrentActivity(id), callback);
+    continue_with(m_service.setCurrentActivity(id), this, callback);
 }
 
 // QFuture<QString> Controller::addActivity(name)
 void ActivityModel::addActivity(const QString &name, const QJSValue &callback)
 {
-    continue_with(m_service.addActivity(name), callback);
+    continue_with(m_service.addActivity(name), this, callback);
 }
 
 // QFuture<void> Controller::removeActivity(id)
 void ActivityModel::removeActivity(const QString &id, const QJSValue &callback)
 {
-    continue_with(m_service.removeActivity(id), callback);
+    continue_with(m_service.removeActivity(id), this, callback);
 }
 
 // QFuture<void> Controller::stopActivity(id)
 void ActivityModel::stopActivity(const QString &id, const QJSValue &callback)
 {
-    continue_with(m_service.stopActivity(id), callback);
+    continue_with(m_service.stopActivity(id), this, callback);
 }
 
 // QFuture<void> Controller::startActivity(id)
 void ActivityModel::startActivity(const QString &id, const QJSValue &callback)
 {
-    continue_with(m_service.startActivity(id), callback);
+    continue_with(m_service.startActivity(id), this, callback);
 }
 
 } // namespace Imports
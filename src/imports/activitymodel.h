@@ -12,6 +12,8 @@
 #include <QCollator>
 #include <QJSValue>
 #include <QObject>
+#include <QSet>
+#include <QTimer>
 
 // STL and Boost
 #include <boost/container/flat_set.hpp>
@@ -104,6 +106,8 @@ private Q_SLOTS:
 
     void setServiceStatus(KActivities::Consumer::ServiceStatus status);
 
+    void publishUpdates();
+
 private:
     KActivities::Controller m_service;
     boost::container::flat_set<State> m_shownStates;
@@ -111,13 +115,20 @@ private:
 
     typedef std::shared_ptr<Info> InfoPtr;
 
+    // The names the activities were sorted by. The sets are ordered by
+    // these instead of the live names so that they stay sorted when an
+    // activity gets renamed, until it is moved to its new place
+    QHash<QString, QString> m_sortedNames;
+
     struct InfoPtrComparator {
+        const QHash<QString, QString> *names;
+
         bool operator()(const InfoPtr &left, const InfoPtr &right) const
         {
             QCollator c;
             c.setCaseSensitivity(Qt::CaseInsensitive);
             c.setNumericMode(true);
-            int rc = c.compare(left->name(), right->name());
+            int rc = c.compare(names->value(left->id()), names->value(right->id()));
             if (rc == 0) {
                 return left->id() < right->id();
             }
@@ -132,10 +143,19 @@ private:
     void unregisterActivity(const QString &id);
     void showActivity(InfoPtr activityInfo, bool notifyClients);
     void hideActivity(const QString &id);
+    void repositionActivity(const InfoPtr &activityInfo);
     void backgroundsUpdated(const QStringList &activities);
 
     InfoPtr findActivity(QObject *ptr) const;
 
+    // The updates are collected during one event loop turn
+    // and reported to the views as a single range
+    void scheduleUpdate(const QString &id, const QList<int> &roles);
+
+    QSet<QString> m_pendingUpdates;
+    QSet<int> m_pendingRoles;
+    QTimer m_updatesTimer;
+
     class Private;
     friend class Private;
 };
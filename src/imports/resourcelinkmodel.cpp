@@ -0,0 +1,292 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Self
+#include "resourcelinkmodel.h"
+
+// Qt
+#include <QCoreApplication>
+#include <QPointer>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QThreadPool>
+
+// STL
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace KActivities
+{
+namespace Imports
+{
+namespace
+{
+// A connection can not be shared between threads, so every worker
+// thread gets its own, and keeps it (along with the prepared statements)
+// for as long as the thread lives
+class WorkerConnection
+{
+public:
+    explicit WorkerConnection(const QString &databaseFile)
+        : m_databaseFile(databaseFile)
+        , m_connectionName(QStringLiteral("kactivities_db_resources_worker_") + QString::number(s_connectionCount++))
+    {
+        m_database = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), m_connectionName);
+        m_database.setDatabaseName(databaseFile);
+        m_database.setConnectOptions(QStringLiteral("QSQLITE_OPEN_READONLY"));
+    }
+
+    ~WorkerConnection()
+    {
+        m_queries.reset();
+        m_database = QSqlDatabase();
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+
+    const QString &databaseFile() const
+    {
+        return m_databaseFile;
+    }
+
+    ResourceLinkQueries *queries()
+    {
+        if (!m_database.isOpen() && !m_database.open()) {
+            return nullptr;
+        }
+
+        if (!m_queries) {
+            m_queries.emplace(m_database);
+        }
+
+        return &*m_queries;
+    }
+
+private:
+    static inline std::atomic<quint64> s_connectionCount = 0;
+
+    const QString m_databaseFile;
+    const QString m_connectionName;
+    QSqlDatabase m_database;
+    std::optional<ResourceLinkQueries> m_queries;
+};
+
+thread_local std::unique_ptr<WorkerConnection> t_connection;
+
+} // namespace
+
+ResourceLinkModel::ResourceLinkModel(const QString &databaseFile, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_databaseFile(databaseFile)
+    , m_generation(0)
+    , m_loading(false)
+{
+}
+
+ResourceLinkModel::~ResourceLinkModel()
+{
+}
+
+int ResourceLinkModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_links.size();
+}
+
+QVariant ResourceLinkModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_links.size()) {
+        return QVariant();
+    }
+
+    const auto &link = m_links[index.row()];
+
+    // clang-format off
+    return role == ResourceRole ? link.resource :
+           role == AgentRole    ? link.agent :
+           role == ActivityRole ? link.activity :
+                                  QVariant();
+    // clang-format on
+}
+
+const ResourceLinkModel::Link &ResourceLinkModel::linkAt(int row) const
+{
+    return m_links[row];
+}
+
+bool ResourceLinkModel::contains(const Link &link) const
+{
+    return m_index.contains(link);
+}
+
+bool ResourceLinkModel::isLoading() const
+{
+    return m_loading;
+}
+
+QList<ResourceLinkModel::Link> ResourceLinkModel::queryLinks(const QString &databaseFile, const ResourceLinkFilter &filter)
+{
+    if (!t_connection || t_connection->databaseFile() != databaseFile) {
+        t_connection = std::make_unique<WorkerConnection>(databaseFile);
+    }
+
+    QList<Link> result;
+
+    auto queries = t_connection->queries();
+    if (!queries) {
+        return result;
+    }
+
+    if (auto query = queries->select(filter)) {
+        while (query->next()) {
+            result.append(Link{query->value(0).toString(), query->value(1).toString(), query->value(2).toString()});
+        }
+        query->finish();
+    }
+
+    return result;
+}
+
+void ResourceLinkModel::load(const ResourceLinkFilter &filter)
+{
+    const auto generation = ++m_generation;
+    m_loading = true;
+    m_pendingChanges.clear();
+
+    QThreadPool::globalInstance()->start([self = QPointer(this), generation, databaseFile = m_databaseFile, filter] {
+        auto links = queryLinks(databaseFile, filter);
+
+        // The model might be gone by the time the query finishes,
+        // so we are not posting directly to it
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [self, generation, links = std::move(links)]() mutable {
+                // A newer query has been issued in the meantime
+                if (!self || self->m_generation != generation) {
+                    return;
+                }
+
+                self->m_loading = false;
+                self->setLinks(std::move(links));
+
+                const auto changes = std::exchange(self->m_pendingChanges, {});
+                for (const auto &change : changes) {
+                    if (change.inserted) {
+                        self->insertLink(change.link);
+                    } else {
+                        self->removeLink(change.link);
+                    }
+                }
+
+                Q_EMIT self->loaded();
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void ResourceLinkModel::rebuildIndex()
+{
+    m_index.clear();
+    m_index.reserve(m_links.size());
+
+    for (int row = 0; row < m_links.size(); ++row) {
+        m_index.insert(m_links[row], row);
+    }
+}
+
+void ResourceLinkModel::setLinks(QList<Link> links)
+{
+    const QSet<Link> newLinks(links.cbegin(), links.cend());
+
+    QList<int> removedRows;
+    for (int row = 0; row < m_links.size(); ++row) {
+        if (!newLinks.contains(m_links[row])) {
+            removedRows << row;
+        }
+    }
+
+    QList<Link> addedLinks;
+    for (const auto &link : std::as_const(links)) {
+        if (!m_index.contains(link)) {
+            addedLinks << link;
+        }
+    }
+
+    // When the filter has changed, almost nothing is kept,
+    // and resetting the model is cheaper for the views
+    if (removedRows.size() + addedLinks.size() > m_links.size() / 2) {
+        beginResetModel();
+        m_links = std::move(links);
+        rebuildIndex();
+        endResetModel();
+        return;
+    }
+
+    // Removing from the back so that the rows we still need to remove
+    // do not move. The index is not used while we are doing this
+    for (auto it = removedRows.crbegin(); it != removedRows.crend(); ++it) {
+        beginRemoveRows(QModelIndex(), *it, *it);
+        m_links.removeAt(*it);
+        endRemoveRows();
+    }
+
+    if (!addedLinks.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_links.size(), m_links.size() + addedLinks.size() - 1);
+        m_links.append(addedLinks);
+        endInsertRows();
+    }
+
+    rebuildIndex();
+}
+
+void ResourceLinkModel::insertLink(const Link &link)
+{
+    if (m_loading) {
+        m_pendingChanges.append({true, link});
+    }
+
+    if (m_index.contains(link)) {
+        return;
+    }
+
+    // The order of the rows does not matter, the proxy sorts them
+    const int row = m_links.size();
+
+    beginInsertRows(QModelIndex(), row, row);
+    m_links.append(link);
+    m_index.insert(link, row);
+    endInsertRows();
+}
+
+void ResourceLinkModel::removeLink(const Link &link)
+{
+    if (m_loading) {
+        m_pendingChanges.append({false, link});
+    }
+
+    const auto position = m_index.constFind(link);
+
+    if (position == m_index.cend()) {
+        return;
+    }
+
+    const int row = *position;
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_index.erase(position);
+    m_links.removeAt(row);
+
+    for (int i = row; i < m_links.size(); ++i) {
+        m_index[m_links[i]] = i;
+    }
+    endRemoveRows();
+}
+
+} // namespace Imports
+} // namespace KActivities
+
+#include "moc_resourcelinkmodel.cpp"
@@ -0,0 +1,116 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KACTIVITIES_IMPORTS_RESOURCE_LINK_MODEL_H
+#define KACTIVITIES_IMPORTS_RESOURCE_LINK_MODEL_H
+
+// Qt
+#include <QAbstractListModel>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+// Local
+#include "resourcelinkqueries.h"
+
+namespace KActivities
+{
+namespace Imports
+{
+/**
+ * ResourceLinkModel
+ *
+ * In-memory cache of the rows of the ResourceLink table that match
+ * a filter. The rows are loaded on a worker thread, and afterwards
+ * kept up-to-date by inserting and removing single links, so that
+ * a change does not require the whole table to be queried again.
+ */
+
+class ResourceLinkModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    // These match the roles of the ResourceModel
+    enum Roles {
+        ResourceRole = Qt::UserRole,
+        ActivityRole = Qt::UserRole + 1,
+        AgentRole = Qt::UserRole + 2,
+    };
+
+    struct Link {
+        QString activity;
+        QString agent;
+        QString resource;
+
+        bool operator==(const Link &other) const = default;
+
+        friend size_t qHash(const Link &link, size_t seed = 0)
+        {
+            return qHashMulti(seed, link.activity, link.agent, link.resource);
+        }
+    };
+
+    explicit ResourceLinkModel(const QString &databaseFile, QObject *parent = nullptr);
+    ~ResourceLinkModel() override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    const Link &linkAt(int row) const;
+    bool contains(const Link &link) const;
+
+    /**
+     * Whether there is a query running on the worker thread whose
+     * results have not yet been applied to the model
+     */
+    bool isLoading() const;
+
+    /**
+     * Replaces the contents of the model with the links that match
+     * the specified filter. The query is executed on a worker
+     * thread. When the results arrive, only the rows that differ
+     * are removed and inserted, unless most of them have changed.
+     * If load is called again before that, the results of the
+     * previous query are discarded.
+     */
+    void load(const ResourceLinkFilter &filter);
+
+    /**
+     * Inserts or removes a single link. While a query is running,
+     * the change is recorded and applied on top of its results since
+     * the query might have been executed before the link was changed.
+     */
+    void insertLink(const Link &link);
+    void removeLink(const Link &link);
+
+Q_SIGNALS:
+    void loaded();
+
+private:
+    static QList<Link> queryLinks(const QString &databaseFile, const ResourceLinkFilter &filter);
+    void setLinks(QList<Link> links);
+    void rebuildIndex();
+
+    struct Change {
+        bool inserted;
+        Link link;
+    };
+    QList<Change> m_pendingChanges;
+
+    const QString m_databaseFile;
+
+    QList<Link> m_links;
+    QHash<Link, int> m_index;
+
+    quint64 m_generation;
+    bool m_loading;
+};
+
+} // namespace Imports
+} // namespace KActivities
+
+#endif // KACTIVITIES_IMPORTS_RESOURCE_LINK_MODEL_H
@@ -0,0 +1,123 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Self
+#include "resourcelinkqueries.h"
+
+// Qt
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QVariant>
+
+namespace KActivities
+{
+namespace Imports
+{
+namespace
+{
+const auto activityParameter = QStringLiteral(":activities");
+const auto agentParameter = QStringLiteral(":agents");
+const auto resourceParameter = QStringLiteral(":resource");
+
+QString condition(const QString &column, const QString &parameter, bool any, const QStringList &values)
+{
+    // clang-format off
+    return any                  ? QStringLiteral("1") :
+           values.isEmpty()     ? QStringLiteral("0") :
+           values.size() == 1   ? column + QStringLiteral(" = ") + parameter :
+                                  column + QStringLiteral(" IN (SELECT value FROM json_each(") + parameter + QStringLiteral("))");
+    // clang-format on
+}
+
+void bind(QSqlQuery *query, const QString &parameter, bool any, const QStringList &values)
+{
+    if (any || values.isEmpty()) {
+        return;
+    }
+
+    if (values.size() != 1) {
+        query->bindValue(parameter, QString::fromUtf8(QJsonDocument(QJsonArray::fromStringList(values)).toJson(QJsonDocument::Compact)));
+        return;
+    }
+
+    // The global links have an empty activity or agent. A null
+    // string would be bound as NULL which is not equal to anything
+    query->bindValue(parameter, values.first().isNull() ? QStringLiteral("") : values.first());
+}
+
+QString whereClause(const ResourceLinkFilter &filter)
+{
+    return condition(QStringLiteral("usedActivity"), activityParameter, filter.anyActivity, filter.activities) + QStringLiteral(" AND ")
+        + condition(QStringLiteral("initiatingAgent"), agentParameter, filter.anyAgent, filter.agents);
+}
+
+} // namespace
+
+ResourceLinkQueries::ResourceLinkQueries(const QSqlDatabase &database)
+    : m_database(database)
+{
+}
+
+QSqlQuery *ResourceLinkQueries::prepare(const QString &queryText)
+{
+    auto position = m_statements.find(queryText);
+
+    if (position == m_statements.end()) {
+        QSqlQuery query(m_database);
+        query.setForwardOnly(true);
+
+        if (!query.prepare(queryText)) {
+            return nullptr;
+        }
+
+        position = m_statements.insert(queryText, std::move(query));
+    }
+
+    return &*position;
+}
+
+bool ResourceLinkQueries::exec(QSqlQuery *query, const ResourceLinkFilter &filter)
+{
+    bind(query, activityParameter, filter.anyActivity, filter.activities);
+    bind(query, agentParameter, filter.anyAgent, filter.agents);
+
+    return query->exec();
+}
+
+QSqlQuery *ResourceLinkQueries::select(const ResourceLinkFilter &filter)
+{
+    auto query = prepare(QStringLiteral("SELECT usedActivity, initiatingAgent, targettedResource FROM ResourceLink WHERE ") + whereClause(filter));
+
+    if (!query || !exec(query, filter)) {
+        return nullptr;
+    }
+
+    return query;
+}
+
+bool ResourceLinkQueries::contains(const ResourceLinkFilter &filter, const QString &resource)
+{
+    auto query = prepare(QStringLiteral("SELECT 1 FROM ResourceLink WHERE targettedResource = ") + resourceParameter + QStringLiteral(" AND ")
+                         + whereClause(filter) + QStringLiteral(" LIMIT 1"));
+
+    if (!query) {
+        return false;
+    }
+
+    query->bindValue(resourceParameter, resource);
+
+    if (!exec(query, filter)) {
+        return false;
+    }
+
+    const bool result = query->next();
+    query->finish();
+
+    return result;
+}
+
+} // namespace Imports
+} // namespace KActivities
@@ -0,0 +1,70 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KACTIVITIES_IMPORTS_RESOURCE_LINK_QUERIES_H
+#define KACTIVITIES_IMPORTS_RESOURCE_LINK_QUERIES_H
+
+// Qt
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+
+namespace KActivities
+{
+namespace Imports
+{
+/**
+ * Which links are we interested in. The special values like
+ * :current and :global need to be resolved before they get here,
+ * the lists contain the actual values from the database
+ */
+struct ResourceLinkFilter {
+    bool anyActivity = false;
+    QStringList activities;
+
+    bool anyAgent = false;
+    QStringList agents;
+};
+
+/**
+ * ResourceLinkQueries
+ *
+ * Prepared statements for querying the ResourceLink table on a single
+ * connection. The filter values are always bound as parameters, so
+ * there is only a handful of different statements - one per filter
+ * shape (any value, a single value, or a list of values passed to
+ * json_each) - and each gets prepared only once.
+ */
+class ResourceLinkQueries
+{
+public:
+    explicit ResourceLinkQueries(const QSqlDatabase &database);
+
+    /**
+     * Executes the query for the links matching the filter, returns
+     * the query positioned before the first (activity, agent, resource)
+     * row, or nullptr if the query failed
+     */
+    QSqlQuery *select(const ResourceLinkFilter &filter);
+
+    /**
+     * Tests whether the resource has any links matching the filter
+     */
+    bool contains(const ResourceLinkFilter &filter, const QString &resource);
+
+private:
+    QSqlQuery *prepare(const QString &queryText);
+    bool exec(QSqlQuery *query, const ResourceLinkFilter &filter);
+
+    QSqlDatabase m_database;
+    QHash<QString, QSqlQuery> m_statements;
+};
+
+} // namespace Imports
+} // namespace KActivities
+
+#endif // KACTIVITIES_IMPORTS_RESOURCE_LINK_QUERIES_H
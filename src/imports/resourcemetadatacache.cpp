@@ -0,0 +1,173 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Self
+#include "resourcemetadatacache.h"
+
+// Qt
+#include <QCoreApplication>
+#include <QThreadPool>
+#include <QUrl>
+
+// KDE
+#include <KDesktopFile>
+#include <KFileItem>
+
+// STL
+#include <mutex>
+
+namespace KActivities
+{
+namespace Imports
+{
+ResourceMetadataCache::ResourceMetadataCache()
+    : QObject()
+    , m_maxEntries([] {
+        const auto maxEntries = QCoreApplication::instance()->property("org.kde.KActivities.imports.metadataCacheSize");
+        return maxEntries.isValid() ? maxEntries.toInt() : 1000;
+    }())
+{
+    connect(&m_watcher, &KDirWatch::dirty, this, &ResourceMetadataCache::invalidate);
+    connect(&m_watcher, &KDirWatch::created, this, &ResourceMetadataCache::invalidate);
+    connect(&m_watcher, &KDirWatch::deleted, this, &ResourceMetadataCache::invalidate);
+}
+
+ResourceMetadataCache::~ResourceMetadataCache()
+{
+}
+
+std::shared_ptr<ResourceMetadataCache> ResourceMetadataCache::self()
+{
+    static std::weak_ptr<ResourceMetadataCache> s_instance;
+    static std::mutex singleton;
+
+    std::lock_guard<std::mutex> singleton_lock(singleton);
+
+    auto result = s_instance.lock();
+
+    if (s_instance.expired()) {
+        result.reset(new ResourceMetadataCache());
+        s_instance = result;
+    }
+
+    return result;
+}
+
+QString ResourceMetadataCache::urlFor(const QString &resource)
+{
+    // TODO: Will probably need some more special handling -
+    //       for application:/ and a few more
+
+    return resource.startsWith('/') ? QLatin1String("file://") + resource : resource;
+}
+
+ResourceMetadataCache::Metadata ResourceMetadataCache::loadMetadata(const QString &resource)
+{
+    KFileItem file(QUrl(urlFor(resource)));
+
+    if (file.mimetype() == "application/x-desktop") {
+        KDesktopFile desktop(file.localPath());
+        return Metadata{desktop.readGenericName(), desktop.readName(), desktop.readIcon(), true};
+    }
+
+    return Metadata{file.name(), QString(), file.iconName(), true};
+}
+
+const ResourceMetadataCache::Metadata &ResourceMetadataCache::metadata(const QString &resource)
+{
+    auto position = m_metadata.find(resource);
+
+    if (position != m_metadata.end()) {
+        m_recentlyUsed.splice(m_recentlyUsed.begin(), m_recentlyUsed, position->recency);
+        return position->metadata;
+    }
+
+    // Making room before inserting, so that the new entry is never
+    // the one being evicted
+    while (!m_recentlyUsed.empty() && m_metadata.size() >= m_maxEntries) {
+        const auto leastRecentlyUsed = m_recentlyUsed.back();
+        evict(leastRecentlyUsed);
+    }
+
+    // The placeholder is stored so that we do not schedule the same
+    // resource more than once while it is being loaded
+    m_recentlyUsed.push_front(resource);
+    position = m_metadata.insert(resource, Entry{Metadata{QUrl(urlFor(resource)).fileName(), QString(), QString(), false}, m_recentlyUsed.begin()});
+
+    QThreadPool::globalInstance()->start([self = weak_from_this(), resource] {
+        auto metadata = loadMetadata(resource);
+
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [self, resource, metadata = std::move(metadata)]() mutable {
+                if (auto cache = self.lock()) {
+                    cache->setMetadata(resource, std::move(metadata));
+                }
+            },
+            Qt::QueuedConnection);
+    });
+
+    return position->metadata;
+}
+
+void ResourceMetadataCache::setMetadata(const QString &resource, Metadata metadata)
+{
+    const auto position = m_metadata.find(resource);
+
+    // The entry was invalidated or evicted while we were loading it,
+    // a new request will be made when somebody needs it
+    if (position == m_metadata.end()) {
+        return;
+    }
+
+    position->metadata = std::move(metadata);
+
+    const auto path = QUrl(urlFor(resource)).toLocalFile();
+    if (!path.isEmpty() && !m_watchedFiles.contains(path)) {
+        m_watchedFiles.insert(path, resource);
+        m_watcher.addFile(path);
+    }
+
+    Q_EMIT metadataChanged(resource);
+}
+
+void ResourceMetadataCache::evict(const QString &resource)
+{
+    const auto position = m_metadata.find(resource);
+
+    if (position == m_metadata.end()) {
+        return;
+    }
+
+    m_recentlyUsed.erase(position->recency);
+    m_metadata.erase(position);
+
+    // Nobody is notified here, the views that still show
+    // the resource will get it reloaded when they ask for it
+    const auto path = QUrl(urlFor(resource)).toLocalFile();
+    if (!path.isEmpty() && m_watchedFiles.remove(path)) {
+        m_watcher.removeFile(path);
+    }
+}
+
+void ResourceMetadataCache::invalidate(const QString &path)
+{
+    const auto resource = m_watchedFiles.value(path);
+
+    if (resource.isEmpty()) {
+        return;
+    }
+
+    evict(resource);
+
+    // The views will ask for the data again, and get it reloaded
+    Q_EMIT metadataChanged(resource);
+}
+
+} // namespace Imports
+} // namespace KActivities
+
+#include "moc_resourcemetadatacache.cpp"
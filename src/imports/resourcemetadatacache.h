@@ -0,0 +1,94 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KACTIVITIES_IMPORTS_RESOURCE_METADATA_CACHE_H
+#define KACTIVITIES_IMPORTS_RESOURCE_METADATA_CACHE_H
+
+// Qt
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+// KDE
+#include <KDirWatch>
+
+// STL
+#include <list>
+#include <memory>
+
+namespace KActivities
+{
+namespace Imports
+{
+/**
+ * ResourceMetadataCache
+ *
+ * Title, subtitle and icon of the linked resources. Getting these
+ * requires detecting the mimetype and, for .desktop files, parsing
+ * the file, so it is done on a worker thread. Until the data is
+ * ready, a placeholder based only on the resource name is returned.
+ * The cached values are dropped when the file changes on disk,
+ * and the least recently used ones when there are too many of them.
+ */
+
+class ResourceMetadataCache : public QObject, public std::enable_shared_from_this<ResourceMetadataCache>
+{
+    Q_OBJECT
+
+public:
+    struct Metadata {
+        QString title;
+        QString description;
+        QString icon;
+        bool ready = false;
+    };
+
+    static std::shared_ptr<ResourceMetadataCache> self();
+
+    ~ResourceMetadataCache() override;
+
+    /**
+     * Returns the metadata for the resource if it is known, or a
+     * placeholder in which case metadataChanged will be emitted
+     * once the real data is loaded. The reference is valid only
+     * until the next call
+     */
+    const Metadata &metadata(const QString &resource);
+
+Q_SIGNALS:
+    void metadataChanged(const QString &resource);
+
+private:
+    ResourceMetadataCache();
+
+    static QString urlFor(const QString &resource);
+    static Metadata loadMetadata(const QString &resource);
+
+    void setMetadata(const QString &resource, Metadata metadata);
+    void invalidate(const QString &path);
+    void evict(const QString &resource);
+
+    struct Entry {
+        Metadata metadata;
+        std::list<QString>::iterator recency;
+    };
+
+    QHash<QString, Entry> m_metadata;
+
+    // Resources ordered by the last time they were requested,
+    // the most recent ones first
+    std::list<QString> m_recentlyUsed;
+    const int m_maxEntries;
+
+    // Local files whose metadata we have, and the resources they belong to
+    QHash<QString, QString> m_watchedFiles;
+    KDirWatch m_watcher;
+};
+
+} // namespace Imports
+} // namespace KActivities
+
+#endif // KACTIVITIES_IMPORTS_RESOURCE_METADATA_CACHE_H
@@ -10,23 +10,20 @@
 // Qt
 #include <QByteArray>
 #include <QCoreApplication>
+#include <QDBusPendingCallWatcher>
 #include <QDebug>
 #include <QModelIndex>
-#include <QSqlQuery>
+#include <QPromise>
 #include <QUuid>
 
 // KDE
 #include <KConfig>
-#include <KDesktopFile>
-#include <KFileItem>
 #include <ksharedconfig.h>
 
 // STL and Boost
 #include <boost/algorithm/string/join.hpp>
 #include <boost/range/adaptor/filtered.hpp>
-#include <boost/range/adaptor/transformed.hpp>
 #include <boost/range/algorithm/find_if.hpp>
-#include <boost/range/numeric.hpp>
 #include <mutex>
 
 // Local
@@ -37,11 +34,6 @@
 #define ENABLE_QJSVALUE_CONTINUATION
 #include "utils/continue_with.h"
 
-#define ACTIVITY_COLUMN 0
-#define AGENT_COLUMN 1
-#define RESOURCE_COLUMN 2
-#define UNKNOWN_COLUMN 3
-
 using kamd::utils::continue_with;
 
 namespace KActivities
@@ -53,10 +45,85 @@ class ResourceModel::LinkerService : public QDBusInterface
 private:
     LinkerService()
         : KAMD_DBUS_INTERFACE("Resources/Linking", ResourcesLinking, nullptr)
+        , m_batchSupported(true)
+    {
+    }
+
+    // Older services do not have the batch methods, we find that out
+    // on the first batch call, and use the single-link ones from then on
+    bool m_batchSupported;
+
+    void changeLinksOneByOne(const QString &method, const QList<ResourceLinkModel::Link> &links, const std::shared_ptr<QPromise<void>> &result)
     {
+        if (links.isEmpty()) {
+            result->finish();
+            return;
+        }
+
+        // All the calls are sent at once, and we are finished
+        // when the last reply arrives
+        auto remaining = std::make_shared<int>(links.size());
+
+        for (const auto &link : links) {
+            auto watcher = new QDBusPendingCallWatcher(asyncCall(method, link.agent, link.resource, link.activity), this);
+
+            connect(watcher, &QDBusPendingCallWatcher::finished, this, [watcher, result, remaining] {
+                watcher->deleteLater();
+
+                if (--*remaining == 0) {
+                    result->finish();
+                }
+            });
+        }
+    }
+
+    QFuture<void> changeLinks(const QString &batchMethod, const QString &method, const QList<ResourceLinkModel::Link> &links)
+    {
+        auto result = std::make_shared<QPromise<void>>();
+        result->start();
+
+        if (!m_batchSupported || links.size() < 2) {
+            changeLinksOneByOne(method, links, result);
+            return result->future();
+        }
+
+        QStringList agents, resources, activities;
+        for (const auto &link : links) {
+            agents << link.agent;
+            resources << link.resource;
+            activities << link.activity;
+        }
+
+        auto watcher = new QDBusPendingCallWatcher(asyncCall(batchMethod, agents, resources, activities), this);
+
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, result, method, links] {
+            watcher->deleteLater();
+
+            if (watcher->isError() && watcher->error().type() == QDBusError::UnknownMethod) {
+                m_batchSupported = false;
+                changeLinksOneByOne(method, links, result);
+                return;
+            }
+
+            result->finish();
+        });
+
+        return result->future();
     }
 
 public:
+    // The batch methods are not part of the service interface (yet), they
+    // are called by name and we fall back to the single calls without them
+    QFuture<void> linkResources(const QList<ResourceLinkModel::Link> &links)
+    {
+        return changeLinks(QStringLiteral("LinkResourcesToActivities"), QStringLiteral("LinkResourceToActivity"), links);
+    }
+
+    QFuture<void> unlinkResources(const QList<ResourceLinkModel::Link> &links)
+    {
+        return changeLinks(QStringLiteral("UnlinkResourcesFromActivities"), QStringLiteral("UnlinkResourceFromActivity"), links);
+    }
+
     static std::shared_ptr<LinkerService> self()
     {
         static std::weak_ptr<LinkerService> s_instance;
@@ -77,10 +144,12 @@ public:
 
 ResourceModel::ResourceModel(QObject *parent)
     : QSortFilterProxyModel(parent)
+    , m_linkModel(nullptr)
     , m_shownActivities(QStringLiteral(":current"))
     , m_shownAgents(QStringLiteral(":current"))
     , m_defaultItemsLoaded(false)
     , m_linker(LinkerService::self())
+    , m_metadata(ResourceMetadataCache::self())
     , m_config(KSharedConfig::openConfig("kactivitymanagerd-resourcelinkingrc")->group("Order"))
 {
     // NOTE: What to do if the file does not exist?
@@ -102,6 +171,8 @@ ResourceModel::ResourceModel(QObject *parent)
             this,
             SLOT(onResourceUnlinkedFromActivity(QString, QString, QString)));
 
+    connect(m_metadata.get(), &ResourceMetadataCache::metadataChanged, this, &ResourceModel::onMetadataChanged);
+
     setDynamicSortFilter(true);
     sort(0);
 }
@@ -121,12 +192,16 @@ bool ResourceModel::loadDatabase()
     m_database.setDatabaseName(m_databaseFile);
 
     m_database.open();
+    m_queries.emplace(m_database);
 
-    m_databaseModel = new QSqlTableModel(this, m_database);
-    m_databaseModel->setTable("ResourceLink");
-    m_databaseModel->select();
+    // The rows are loaded asynchronously, so we can only know whether
+    // the defaults are needed once the model gets the data
+    m_linkModel = new ResourceLinkModel(m_databaseFile, this);
+    connect(m_linkModel, &ResourceLinkModel::loaded, this, [this] {
+        loadDefaultsIfNeeded();
+    });
 
-    setSourceModel(m_databaseModel);
+    setSourceModel(m_linkModel);
 
     reloadData();
 
@@ -137,26 +212,12 @@ ResourceModel::~ResourceModel()
 {
 }
 
-QVariant ResourceModel::dataForColumn(const QModelIndex &index, int column) const
-{
-    if (!m_database.isValid())
-        return QVariant();
-
-    return m_databaseModel->data(index.sibling(index.row(), column), Qt::DisplayRole);
-}
-
 bool ResourceModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
 {
-    const auto leftResource = dataForColumn(left, RESOURCE_COLUMN).toString();
-    const auto rightResource = dataForColumn(right, RESOURCE_COLUMN).toString();
+    const auto &leftResource = m_linkModel->linkAt(left.row()).resource;
+    const auto &rightResource = m_linkModel->linkAt(right.row()).resource;
 
-    const bool hasLeft = m_sorting.contains(leftResource);
-    const bool hasRight = m_sorting.contains(rightResource);
-
-    return (hasLeft && !hasRight) ? true
-        : (!hasLeft && hasRight)  ? false
-        : (hasLeft && hasRight)   ? m_sorting.indexOf(leftResource) < m_sorting.indexOf(rightResource)
-                                  : QString::compare(leftResource, rightResource, Qt::CaseInsensitive) < 0;
+    return m_sorting(leftResource, rightResource);
 }
 
 QHash<int, QByteArray> ResourceModel::roleNames() const
@@ -226,57 +287,40 @@ void ResourceModel::setDefaultItemsConfig(const QString &defaultItemsConfig)
     loadDefaultsIfNeeded();
 }
 
-QString ResourceModel::activityToWhereClause(const QString &shownActivity) const
-{
-    return QStringLiteral(" OR usedActivity=")
-        + (shownActivity == ":current"      ? "'" + m_service.currentActivity() + "'"
-               : shownActivity == ":any"    ? "usedActivity"
-               : shownActivity == ":global" ? "''"
-                                            : "'" + shownActivity + "'");
-}
-
-QString ResourceModel::agentToWhereClause(const QString &shownAgent) const
-{
-    return QStringLiteral(" OR initiatingAgent=")
-        + (shownAgent == ":current"      ? "'" + QCoreApplication::applicationName() + "'"
-               : shownAgent == ":any"    ? "initiatingAgent"
-               : shownAgent == ":global" ? "''"
-                                         : "'" + shownAgent + "'");
-}
-
-QString ResourceModel::whereClause(const QStringList &activities, const QStringList &agents) const
+ResourceLinkFilter ResourceModel::filter(const QStringList &activities, const QStringList &agents) const
 {
-    using boost::accumulate;
-    using namespace kamd::utils;
+    // Resolving the special values like :current, :any and :global,
+    // the values themselves are bound to the query as parameters
+    ResourceLinkFilter result;
 
-    // qDebug() << "Getting the where clause for: " << activities << " " << agents;
-
-    // Defining the transformation functions for generating the SQL WHERE clause
-    // from the specified activity/agent. They also resolve the special values
-    // like :current, :any and :global.
-
-    auto activityToWhereClause = transformed(&ResourceModel::activityToWhereClause, this);
-    auto agentToWhereClause = transformed(&ResourceModel::agentToWhereClause, this);
-
-    // Generating the SQL WHERE part by concatenating the generated clauses.
-    // The generated query will be in the form of '0 OR clause1 OR clause2 ...'
-
-    const QString whereActivity = accumulate(activities | activityToWhereClause, QStringLiteral("0"));
+    for (const auto &activity : activities) {
+        if (activity == ":any") {
+            result.anyActivity = true;
+        } else {
+            result.activities << resolvedActivity(activity);
+        }
+    }
 
-    const QString whereAgent = accumulate(agents | agentToWhereClause, QStringLiteral("0"));
+    for (const auto &agent : agents) {
+        if (agent == ":any") {
+            result.anyAgent = true;
+        } else {
+            result.agents << (agent == ":current" ? QCoreApplication::applicationName() : agent == ":global" ? QString() : agent);
+        }
+    }
 
-    // qDebug() << "This is the filter: " << '(' + whereActivity + ") AND (" + whereAgent + ')';
+    // qDebug() << "This is the filter: " << result.activities << result.agents;
 
-    return '(' + whereActivity + ") AND (" + whereAgent + ')';
+    return result;
 }
 
 void ResourceModel::reloadData()
 {
-    m_sorting = m_config.readEntry(m_shownAgents.first(), QStringList());
+    m_sorting.setResources(m_config.readEntry(m_shownAgents.first(), QStringList()));
 
     if (!m_database.isValid())
         return;
-    m_databaseModel->setFilter(whereClause(m_shownActivities, m_shownAgents));
+    m_linkModel->load(filter(m_shownActivities, m_shownAgents));
 }
 
 void ResourceModel::onCurrentActivityChanged(const QString &activity)
@@ -293,36 +337,18 @@ QVariant ResourceModel::data(const QModelIndex &proxyIndex, int role) const
     auto index = mapToSource(proxyIndex);
 
     if (role == Qt::DisplayRole || role == DescriptionRole || role == Qt::DecorationRole) {
-        auto uri = dataForColumn(index, RESOURCE_COLUMN).toString();
-
-        // TODO: Will probably need some more special handling -
-        //       for application:/ and a few more
+        // This never touches the disk, if the metadata is not loaded yet,
+        // we get a placeholder and a notification once it is
+        const auto &metadata = m_metadata->metadata(index.data(ResourceRole).toString());
 
-        if (uri.startsWith('/')) {
-            uri = QLatin1String("file://") + uri;
-        }
-
-        KFileItem file(uri);
         // clang-format off
-        if (file.mimetype() == "application/x-desktop") {
-            KDesktopFile desktop(file.localPath());
-
-            return role == Qt::DisplayRole    ? desktop.readGenericName() :
-                   role == DescriptionRole    ? desktop.readName() :
-                   role == Qt::DecorationRole ? desktop.readIcon() : QVariant();
-        }
-
-        return role == Qt::DisplayRole    ? file.name() :
-               role == Qt::DecorationRole ? file.iconName() : QVariant();
+        return role == Qt::DisplayRole    ? metadata.title :
+               role == DescriptionRole    ? metadata.description :
+               role == Qt::DecorationRole ? metadata.icon : QVariant();
+        // clang-format on
     }
 
-    return dataForColumn(index,
-            role == ResourceRole ? RESOURCE_COLUMN :
-            role == AgentRole    ? AGENT_COLUMN :
-            role == ActivityRole ? ACTIVITY_COLUMN :
-                                   UNKNOWN_COLUMN
-        );
-    // clang-format on
+    return index.data(role);
 }
 
 void ResourceModel::linkResourceToActivity(const QString &resource, const QJSValue &callback) const
@@ -349,13 +375,7 @@ void ResourceModel::linkResourceToActivity(const QString &agent, const QString &
     //          << "ResourceModel:         Agents: " << agent << "\n"
     //          << "ResourceModel:         Activities: " << activity << "\n";
 
-    kamd::utils::continue_with(DBusFuture::asyncCall<void>(m_linker.get(),
-                                                           QStringLiteral("LinkResourceToActivity"),
-                                                           agent,
-                                                           resource,
-                                                           activity == ":current"      ? m_service.currentActivity()
-                                                               : activity == ":global" ? ""
-                                                                                       : activity),
+    kamd::utils::continue_with(DBusFuture::asyncCall<void>(m_linker.get(), QStringLiteral("LinkResourceToActivity"), agent, resource, resolvedActivity(activity)),
                                callback);
 }
 
@@ -383,26 +403,23 @@ void ResourceModel::unlinkResourceFromActivity(const QStringList &agents, const
     //          << "ResourceModel:         Agents: " << agents << "\n"
     //          << "ResourceModel:         Activities: " << activities << "\n";
 
+    if (activities.contains(":any")) {
+        qWarning() << ":any is not a valid activity specification for linking";
+        return;
+    }
+
+    QList<ResourceLinkModel::Link> links;
+    links.reserve(agents.size() * activities.size());
+
     for (const auto &agent : agents) {
         for (const auto &activity : activities) {
-            if (activity == ":any") {
-                qWarning() << ":any is not a valid activity specification for linking";
-                return;
-            }
-
-            // We might want to compose the continuations into one
-            // so that the callback gets called only once,
-            // but we don't care about that at the moment
-            kamd::utils::continue_with(DBusFuture::asyncCall<void>(m_linker.get(),
-                                                                   QStringLiteral("UnlinkResourceFromActivity"),
-                                                                   agent,
-                                                                   resource,
-                                                                   activity == ":current"      ? m_service.currentActivity()
-                                                                       : activity == ":global" ? ""
-                                                                                               : activity),
-                                       callback);
+            links.append({resolvedActivity(activity), agent, resource});
         }
     }
+
+    // All the links are removed in one go, and the callback
+    // is called once, when all of them are gone
+    kamd::utils::continue_with(m_linker->unlinkResources(links), callback);
 }
 
 bool ResourceModel::isResourceLinkedToActivity(const QString &resource)
@@ -432,36 +449,27 @@ bool ResourceModel::isResourceLinkedToActivity(const QStringList &agents, const
     //          << "ResourceModel:         Agents: " << agents << "\n"
     //          << "ResourceModel:         Activities: " << activities << "\n";
 
-    QSqlQuery query(m_database);
-    query.prepare(
-        "SELECT targettedResource "
-        "FROM ResourceLink "
-        "WHERE targettedResource=:resource AND "
-        + whereClause(activities, agents));
-    query.bindValue(":resource", resource);
-    query.exec();
-
-    auto result = query.next();
-
-    // qDebug() << "Query: " << query.lastQuery();
-    //
-    // if (query.lastError().isValid()) {
-    //     qDebug() << "Error: " << query.lastError();
-    // }
-    //
+    // If we are asked about the links that the model already shows,
+    // there is no need to go to the database
+    if (agents == m_shownAgents && activities == m_shownActivities && !m_linkModel->isLoading()) {
+        for (int row = 0; row < m_linkModel->rowCount(); ++row) {
+            if (m_linkModel->linkAt(row).resource == resource) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto result = m_queries->contains(filter(activities, agents), resource);
+
     // qDebug() << "Result: " << result;
 
     return result;
 }
 
-void ResourceModel::onResourceLinkedToActivity(const QString &initiatingAgent, const QString &targettedResource, const QString &usedActivity)
+bool ResourceModel::isShownActivity(const QString &usedActivity) const
 {
-    Q_UNUSED(targettedResource);
-
-    if (!loadDatabase())
-        return;
-
-    auto matchingActivity = boost::find_if(m_shownActivities, [&](const QString &shownActivity) {
+    return boost::find_if(m_shownActivities, [&](const QString &shownActivity) {
         return
             // If the activity is not important
             shownActivity == ":any" ||
@@ -471,9 +479,12 @@ void ResourceModel::onResourceLinkedToActivity(const QString &initiatingAgent, c
             (shownActivity == ":global" && usedActivity.isEmpty()) ||
             // or we have a specific activity in mind
             shownActivity == usedActivity;
-    });
+    }) != m_shownActivities.end();
+}
 
-    auto matchingAgent = boost::find_if(m_shownAgents, [&](const QString &shownAgent) {
+bool ResourceModel::isShownAgent(const QString &initiatingAgent) const
+{
+    return boost::find_if(m_shownAgents, [&](const QString &shownAgent) {
         return
             // If the agent is not important
             shownAgent == ":any" ||
@@ -483,26 +494,70 @@ void ResourceModel::onResourceLinkedToActivity(const QString &initiatingAgent, c
             (shownAgent == ":global" && initiatingAgent.isEmpty()) ||
             // or we have a specific agent to listen for
             shownAgent == initiatingAgent;
-    });
+    }) != m_shownAgents.end();
+}
 
-    if (matchingActivity != m_shownActivities.end() && matchingAgent != m_shownAgents.end()) {
-        // TODO: This might be smarter possibly, but might collide
-        //       with the SQL model. Implement a custom model with internal
-        //       cache instead of basing it on QSqlModel.
+void ResourceModel::onResourceLinkedToActivity(const QString &initiatingAgent, const QString &targettedResource, const QString &usedActivity)
+{
+    // If the database was not there before, we have just loaded it
+    // completely, so there is nothing to apply
+    if (!m_database.isValid()) {
+        loadDatabase();
+        return;
+    }
+
+    if (!isShownActivity(usedActivity) || !isShownAgent(initiatingAgent))
+        return;
+
+    // The signal carries the resource in the form the client passed it,
+    // which is not necessarily the form it was stored in (an url instead
+    // of a local path). We can not guess that, so we ask the database
+    if (validateResource(targettedResource) != targettedResource) {
         reloadData();
+        return;
     }
+
+    m_linkModel->insertLink({usedActivity, initiatingAgent, targettedResource});
 }
 
 void ResourceModel::onResourceUnlinkedFromActivity(const QString &initiatingAgent, const QString &targettedResource, const QString &usedActivity)
 {
-    // These are the same at the moment
-    onResourceLinkedToActivity(initiatingAgent, targettedResource, usedActivity);
+    if (!m_database.isValid()) {
+        loadDatabase();
+        return;
+    }
+
+    if (!isShownActivity(usedActivity) || !isShownAgent(initiatingAgent))
+        return;
+
+    const ResourceLinkModel::Link link{usedActivity, initiatingAgent, targettedResource};
+
+    if (!m_linkModel->isLoading() && !m_linkModel->contains(link) && validateResource(targettedResource) != targettedResource) {
+        reloadData();
+        return;
+    }
+
+    m_linkModel->removeLink(link);
+}
+
+void ResourceModel::onMetadataChanged(const QString &resource)
+{
+    if (!m_linkModel)
+        return;
+
+    // The same resource can be linked to more than one activity
+    for (int row = 0; row < m_linkModel->rowCount(); ++row) {
+        if (m_linkModel->linkAt(row).resource == resource) {
+            const auto index = mapFromSource(m_linkModel->index(row));
+            Q_EMIT dataChanged(index, index, {Qt::DisplayRole, DescriptionRole, Qt::DecorationRole});
+        }
+    }
 }
 
 void ResourceModel::setOrder(const QStringList &resources)
 {
-    m_sorting = resources;
-    m_config.writeEntry(m_shownAgents.first(), m_sorting);
+    m_sorting.setResources(resources);
+    m_config.writeEntry(m_shownAgents.first(), resources);
     m_config.sync();
     invalidate();
 }
@@ -581,6 +636,10 @@ void ResourceModel::loadDefaultsIfNeeded() const
     // If we have already loaded the items, just exit
     if (m_defaultItemsLoaded)
         return;
+
+    // We will be called again when the model gets its data
+    if (!m_linkModel || m_linkModel->isLoading())
+        return;
     m_defaultItemsLoaded = true;
 
     // If there are items in the model, no need to load the defaults
@@ -607,10 +666,20 @@ void ResourceModel::loadDefaultsIfNeeded() const
 
     QStringList items = KSharedConfig::openConfig(configFile)->group(configGroup).readEntry(configField, QStringList());
 
+    QList<ResourceLinkModel::Link> links;
+    links.reserve(items.size());
+
     for (const auto &item : items) {
         // qDebug() << "Adding: " << item;
-        linkResourceToActivity(item, ":global", QJSValue());
+        links.append({QString(), m_shownAgents.first(), validateResource(item)});
     }
+
+    m_linker->linkResources(links);
+}
+
+QString ResourceModel::resolvedActivity(const QString &activity) const
+{
+    return activity == ":current" ? m_service.currentActivity() : activity == ":global" ? QString() : activity;
 }
 
 QString ResourceModel::validateResource(const QString &resource) const
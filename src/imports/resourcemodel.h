@@ -12,19 +12,23 @@
 #include <QObject>
 #include <QSortFilterProxyModel>
 #include <QSqlDatabase>
-#include <QSqlTableModel>
 
 // KDE
 #include <KConfigGroup>
 
 // STL and Boost
 #include <memory>
+#include <optional>
 
 // Local
 #include <lib/consumer.h>
 #include <lib/controller.h>
 #include <lib/info.h>
 
+#include "resourcelinkmodel.h"
+#include "resourcemetadatacache.h"
+#include "resourceorder.h"
+
 class QModelIndex;
 class QDBusPendingCallWatcher;
 
@@ -132,34 +136,38 @@ private Q_SLOTS:
     void onResourceLinkedToActivity(const QString &initiatingAgent, const QString &targettedResource, const QString &usedActivity);
     void onResourceUnlinkedFromActivity(const QString &initiatingAgent, const QString &targettedResource, const QString &usedActivity);
 
+    void onMetadataChanged(const QString &resource);
+
 private:
     KActivities::Consumer m_service;
 
-    inline QVariant dataForColumn(const QModelIndex &index, int column) const;
+    ResourceLinkFilter filter(const QStringList &activities, const QStringList &agents) const;
 
-    QString activityToWhereClause(const QString &activity) const;
-    QString agentToWhereClause(const QString &agent) const;
-    QString whereClause(const QStringList &activities, const QStringList &agents) const;
+    bool isShownActivity(const QString &activity) const;
+    bool isShownAgent(const QString &agent) const;
 
     void loadDefaultsIfNeeded() const;
 
     bool loadDatabase();
     QString m_databaseFile;
     QSqlDatabase m_database;
-    QSqlTableModel *m_databaseModel;
+    std::optional<ResourceLinkQueries> m_queries;
+    ResourceLinkModel *m_linkModel;
 
     QStringList m_shownActivities;
     QStringList m_shownAgents;
-    QStringList m_sorting;
+    ResourceOrder m_sorting;
 
     QString m_defaultItemsConfig;
     mutable bool m_defaultItemsLoaded;
 
     void reloadData();
     QString validateResource(const QString &resource) const;
+    QString resolvedActivity(const QString &activity) const;
 
     class LinkerService;
     std::shared_ptr<LinkerService> m_linker;
+    std::shared_ptr<ResourceMetadataCache> m_metadata;
 
     mutable KConfigGroup m_config;
 };
@@ -0,0 +1,80 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KACTIVITIES_IMPORTS_RESOURCE_ORDER_H
+#define KACTIVITIES_IMPORTS_RESOURCE_ORDER_H
+
+// Qt
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+namespace KActivities
+{
+namespace Imports
+{
+/**
+ * ResourceOrder
+ *
+ * The order of the resources the user has set. The resources that are
+ * in the list come first, in the order of the list, followed by the rest
+ * sorted alphabetically. The position of each resource is kept in a hash
+ * so that comparing two resources does not need to search the list.
+ */
+class ResourceOrder
+{
+public:
+    ResourceOrder()
+    {
+    }
+
+    explicit ResourceOrder(const QStringList &resources)
+    {
+        setResources(resources);
+    }
+
+    void setResources(const QStringList &resources)
+    {
+        m_resources = resources;
+        m_ranks.clear();
+        m_ranks.reserve(resources.size());
+
+        // If a resource is listed more than once, the first position counts
+        for (int rank = 0; rank < resources.size(); ++rank) {
+            if (!m_ranks.contains(resources[rank])) {
+                m_ranks.insert(resources[rank], rank);
+            }
+        }
+    }
+
+    const QStringList &resources() const
+    {
+        return m_resources;
+    }
+
+    bool operator()(const QString &left, const QString &right) const
+    {
+        const auto leftRank = m_ranks.constFind(left);
+        const auto rightRank = m_ranks.constFind(right);
+
+        const bool hasLeft = leftRank != m_ranks.cend();
+        const bool hasRight = rightRank != m_ranks.cend();
+
+        return (hasLeft && !hasRight) ? true
+            : (!hasLeft && hasRight)  ? false
+            : (hasLeft && hasRight)   ? *leftRank < *rightRank
+                                      : QString::compare(left, right, Qt::CaseInsensitive) < 0;
+    }
+
+private:
+    QStringList m_resources;
+    QHash<QString, int> m_ranks;
+};
+
+} // namespace Imports
+} // namespace KActivities
+
+#endif // KACTIVITIES_IMPORTS_RESOURCE_ORDER_H
@@ -5,18 +5,32 @@
 */
 
 #include "activitiescache_p.h"
+#include "debug_p.h"
+#include "info_p.h"
 #include "manager_p.h"
 
-#include <mutex>
+#include "utils/continue_with.h"
 
+#include <mutex>
+#include <utility>
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
 #include <QString>
+#include <QThread>
 
-#include "mainthreadexecutor_p.h"
 
 namespace KActivities
 {
 static QString nulluuid = QStringLiteral("00000000-0000-0000-0000-000000000000");
 
+static const quint32 s_snapshotMagic = 0x4b414d44; // KAMD
+static const quint32 s_snapshotVersion = 1;
+
 using kamd::utils::Mutable;
 
 std::shared_ptr<ActivitiesCache> ActivitiesCache::self()
@@ -27,11 +41,31 @@ std::shared_ptr<ActivitiesCache> ActivitiesCache::self()
 
     auto result = s_instance.lock();
 
-    if (s_instance.expired()) {
-        runInMainThread([&result] {
-            result.reset(new ActivitiesCache());
-            s_instance = result;
+    if (!result) {
+        // The cache is created in the calling thread and handed over
+        // to the main thread without waiting for it. Until the main
+        // thread loads the data from the service, the cache reports
+        // the offline defaults and the NotRunning status
+        const auto mainThread = QCoreApplication::instance()->thread();
+
+        auto cache = new ActivitiesCache();
+        cache->moveToThread(mainThread);
+
+        // The cache can not be destroyed from a different thread
+        result.reset(cache, [](ActivitiesCache *cache) {
+            if (cache->thread() == QThread::currentThread()) {
+                delete cache;
+            } else {
+                cache->deleteLater();
+            }
         });
+        s_instance = result;
+
+        if (QThread::currentThread() == mainThread) {
+            cache->initialize();
+        } else {
+            QMetaObject::invokeMethod(cache, &ActivitiesCache::initialize, Qt::QueuedConnection);
+        }
     }
 
     return result;
@@ -39,10 +73,29 @@ std::shared_ptr<ActivitiesCache> ActivitiesCache::self()
 
 ActivitiesCache::ActivitiesCache()
     : m_status(Consumer::NotRunning)
+    , m_pendingRunningListChange(false)
+    , m_changesTimer(this)
+    , m_persistTimer(this)
+    , m_persistentSnapshot(QCoreApplication::instance()->property("org.kde.KActivities.core.persistentSnapshot").toBool())
+    , m_reconnectTimer(this)
+    , m_reconnecting(false)
 {
     // qDebug() << "ActivitiesCache: Creating a new instance";
     using org::kde::ActivityManager::Activities;
 
+    // Bursts of changes are collected and published together. By default,
+    // we are collecting them until the next event loop turn
+    m_changesTimer.setSingleShot(true);
+    m_changesTimer.setInterval(QCoreApplication::instance()->property("org.kde.KActivities.core.changeCoalescingInterval").toInt());
+    connect(&m_changesTimer, &QTimer::timeout, this, &ActivitiesCache::publishChanges);
+
+    // When the service disappears, it might be just restarting. We are
+    // keeping the last known state for a while before going offline
+    const auto gracePeriod = QCoreApplication::instance()->property("org.kde.KActivities.core.reconnectGracePeriod");
+    m_reconnectTimer.setSingleShot(true);
+    m_reconnectTimer.setInterval(gracePeriod.isValid() ? gracePeriod.toInt() : 2000);
+    connect(&m_reconnectTimer, &QTimer::timeout, this, &ActivitiesCache::loadOfflineDefaults);
+
     auto activities = Manager::self()->activities();
 
     connect(activities, &Activities::ActivityAdded, this, &ActivitiesCache::updateActivity);
@@ -62,26 +115,169 @@ ActivitiesCache::ActivitiesCache()
     // signal void org.kde.ActivityManager.Activities.ActivityStarted(QString activity)
     // signal void org.kde.ActivityManager.Activities.ActivityStopped(QString activity)
 
-    setServiceStatus(Manager::self()->isServiceRunning());
+    loadOfflineDefaults();
+
+    // Optionally, we can show the state from the previous session
+    // until the service answers
+    if (m_persistentSnapshot) {
+        m_persistTimer.setSingleShot(true);
+        m_persistTimer.setInterval(1000);
+        connect(&m_persistTimer, &QTimer::timeout, this, &ActivitiesCache::savePersistedSnapshot);
+
+        loadPersistedSnapshot();
+    }
+}
+
+void ActivitiesCache::initialize()
+{
+    // The manager might have already reported whether the service is running
+    const auto serviceState = Manager::self()->serviceState();
+
+    if (!m_bootstrap.active && m_status != Consumer::Running && serviceState == Manager::ServiceState::Running) {
+        updateAllActivities();
+
+    } else if (m_status != Consumer::NotRunning && serviceState == Manager::ServiceState::NotRunning) {
+        loadOfflineDefaults();
+    }
 }
 
 void ActivitiesCache::setServiceStatus(bool status)
 {
     // qDebug() << "Setting service status to:" << status;
-    loadOfflineDefaults();
 
+    // When the service appears, the data we have (offline defaults or
+    // the persisted snapshot) gets reconciled with what it reports
     if (status) {
+        m_reconnectTimer.stop();
         updateAllActivities();
+
+    } else if (m_status == Consumer::Running && m_reconnectTimer.interval() > 0) {
+        // Nothing is reported to the clients unless the service
+        // fails to come back in time. This is only for a service we
+        // were connected to, the persisted snapshot is dropped as
+        // soon as we know the service is not there
+        m_reconnecting = true;
+        m_bootstrap = Bootstrap();
+        m_reconnectTimer.start();
+
+    } else {
+        loadOfflineDefaults();
+    }
+}
+
+QString ActivitiesCache::persistedSnapshotPath()
+{
+    const auto runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    return runtimeDir.isEmpty() ? QString() : runtimeDir + QStringLiteral("/plasma-activities.snapshot");
+}
+
+void ActivitiesCache::loadPersistedSnapshot()
+{
+    QFile file(persistedSnapshotPath());
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const auto size = file.size();
+    const auto data = file.map(0, size);
+
+    if (!data) {
+        return;
+    }
+
+    QDataStream stream(QByteArray::fromRawData(reinterpret_cast<const char *>(data), size));
+    stream.setVersion(QDataStream::Qt_6_5);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+
+    if (magic != s_snapshotMagic || version != s_snapshotVersion) {
+        return;
+    }
+
+    QString currentActivity;
+    quint32 count = 0;
+    stream >> currentActivity >> count;
+
+    // The file might be truncated or corrupt. Each record takes at least
+    // 20 bytes (four string lengths and the state), so a count larger than
+    // what the rest of the file can hold is not to be trusted
+    const qint64 minimumRecordSize = 5 * sizeof(quint32);
+
+    if (stream.status() != QDataStream::Ok || count > (size - stream.device()->pos()) / minimumRecordSize) {
+        return;
+    }
+
+    QHash<QString, ActivityInfo> activities;
+    activities.reserve(count);
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        ActivityInfo info;
+        stream >> info.id >> info.name >> info.description >> info.icon >> info.state;
+        activities.insert(info.id, std::move(info));
+    }
+
+    if (stream.status() != QDataStream::Ok || activities.isEmpty()) {
+        return;
+    }
+
+    // The data is stale until the service confirms it,
+    // so we are not reporting the service as running
+    m_activities = std::move(activities);
+    m_sortedActivities = m_activities.keys();
+    std::sort(m_sortedActivities.begin(), m_sortedActivities.end(), [this](const QString &left, const QString &right) {
+        return infoLessThan(*m_activities.constFind(left), *m_activities.constFind(right));
+    });
+    m_currentActivity = currentActivity;
+    m_status = Consumer::Unknown;
+    publishSnapshot();
+}
+
+void ActivitiesCache::savePersistedSnapshot()
+{
+    if (m_status != Consumer::Running) {
+        return;
+    }
+
+    const auto path = persistedSnapshotPath();
+
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QSaveFile file(path);
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
     }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_5);
+
+    stream << s_snapshotMagic << s_snapshotVersion << m_currentActivity << quint32(m_sortedActivities.size());
+
+    for (const auto &id : std::as_const(m_sortedActivities)) {
+        const auto &info = *m_activities.constFind(id);
+        stream << info.id << info.name << info.description << info.icon << info.state;
+    }
+
+    file.commit();
 }
 
 void ActivitiesCache::loadOfflineDefaults()
 {
     m_status = Consumer::NotRunning;
+    m_bootstrap = Bootstrap();
+    m_reconnecting = false;
+    m_reconnectTimer.stop();
 
     m_activities.clear();
-    m_activities << ActivityInfo(nulluuid, QString(), QString(), QString(), Info::Running);
+    m_activities[nulluuid] = ActivityInfo(nulluuid, QString(), QString(), QString(), Info::Running);
+    m_sortedActivities = QStringList{nulluuid};
     m_currentActivity = nulluuid;
+    publishSnapshot();
 
     Q_EMIT serviceStatusChanged(m_status);
     Q_EMIT activityListChanged();
@@ -92,20 +288,90 @@ ActivitiesCache::~ActivitiesCache()
     // qDebug() << "ActivitiesCache: Destroying the instance";
 }
 
+void ActivitiesCache::subscribe(const QString &id, Info *info)
+{
+    QMutexLocker lock(&m_subscribersMutex);
+    m_subscribers[id] << info;
+}
+
+void ActivitiesCache::unsubscribe(const QString &id, Info *info)
+{
+    QMutexLocker lock(&m_subscribersMutex);
+
+    const auto where = m_subscribers.find(id);
+
+    if (where == m_subscribers.end()) {
+        return;
+    }
+
+    where->removeOne(info);
+
+    if (where->isEmpty()) {
+        m_subscribers.erase(where);
+    }
+}
+
+template<typename Handler>
+void ActivitiesCache::notifySubscribers(const QString &id, Handler handler)
+{
+    // The subscribers living in other threads are notified while we are
+    // holding the lock. They unsubscribe before anything else in their
+    // destructors, so none of them can be destroyed in the meantime.
+    // The ones living in this thread are called after the lock is
+    // released since the handlers can create or destroy Info instances
+    QList<QPointer<Info>> local;
+
+    {
+        QMutexLocker lock(&m_subscribersMutex);
+        const auto where = m_subscribers.constFind(id);
+
+        if (where == m_subscribers.cend()) {
+            return;
+        }
+
+        const auto currentThread = QThread::currentThread();
+
+        for (Info *info : *where) {
+            if (info->thread() == currentThread) {
+                local << info;
+
+            } else {
+                QMetaObject::invokeMethod(
+                    info,
+                    [info, handler] {
+                        handler(info->d.get());
+                    },
+                    Qt::QueuedConnection);
+            }
+        }
+    }
+
+    for (const auto &subscriber : std::as_const(local)) {
+        // The handler for one of the previous subscribers
+        // might have destroyed this one
+        if (Info *info = subscriber.data()) {
+            handler(info->d.get());
+        }
+    }
+}
+
 void ActivitiesCache::removeActivity(const QString &id)
 {
     // qDebug() << "Removing the activity";
 
-    // Since we are sorting the activities by name now,
-    // we can not use lower_bound to search for an activity
-    // with a specified id
-    const auto where = find(id);
+    const auto info = getInfo(id);
 
-    if (where != m_activities.end() && where->id == id) {
-        m_activities.erase(where);
+    if (info) {
+        m_sortedActivities.erase(indexOf(*info));
+        m_activities.remove(id);
+        publishSnapshot();
         Q_EMIT activityRemoved(id);
         Q_EMIT activityListChanged();
 
+        notifySubscribers(id, [](InfoPrivate *subscriber) {
+            subscriber->removed();
+        });
+
     } else {
         // qFatal("Requested to delete an non-existent activity");
     }
@@ -114,18 +380,87 @@ void ActivitiesCache::removeActivity(const QString &id)
 void ActivitiesCache::updateAllActivities()
 {
     // qDebug() << "Updating all";
-    m_status = Consumer::Unknown;
-    Q_EMIT serviceStatusChanged(m_status);
+
+    // While reconnecting, the last known state is kept visible
+    // until the new one is applied
+    if (!m_reconnecting) {
+        m_status = Consumer::Unknown;
+        publishSnapshot();
+        Q_EMIT serviceStatusChanged(m_status);
+    }
+
+    // All the startup queries are sent at once, and the results
+    // are applied together when all of them have been answered
+    m_bootstrap = Bootstrap();
+    m_bootstrap.active = true;
+    m_bootstrap.generation = ++m_bootstrapGeneration;
+    m_bootstrap.timer.start();
 
     // Loading the current activity
     auto call = Manager::self()->activities()->asyncCall(QStringLiteral("CurrentActivity"));
 
-    onCallFinished(call, SLOT(setCurrentActivityFromReply(QDBusPendingCallWatcher *)));
+    onBootstrapCallFinished(call, &ActivitiesCache::setCurrentActivityFromReply);
 
     // Loading all the activities
     call = Manager::self()->activities()->asyncCall(QStringLiteral("ListActivitiesWithInformation"));
 
-    onCallFinished(call, SLOT(setAllActivitiesFromReply(QDBusPendingCallWatcher *)));
+    onBootstrapCallFinished(call, &ActivitiesCache::setAllActivitiesFromReply);
+
+    // The version check is sent by the manager, which also handles
+    // the failures, we only need to wait for it to be answered
+    kamd::utils::continue_with(Manager::self()->serviceVersion(), this, [this, generation = m_bootstrap.generation](const std::optional<QString> &) {
+        if (!isCurrentBootstrap(generation)) {
+            return;
+        }
+
+        m_bootstrap.serviceVersionChecked = true;
+        finishBootstrap();
+    });
+}
+
+void ActivitiesCache::failBootstrap(QDBusPendingCallWatcher *watcher)
+{
+    qCWarning(KAMD_CORELIB) << "Failed to load the activities from the service:" << watcher->error().message();
+    watcher->deleteLater();
+
+    // Without the list of activities or the current one, we can not
+    // report the service as running, and we should not keep showing
+    // the state from before a reconnect either
+    loadOfflineDefaults();
+}
+
+void ActivitiesCache::setBootstrapActivities(ActivityInfoList activities)
+{
+    if (!m_bootstrap.active) {
+        setAllActivities(std::move(activities));
+        return;
+    }
+
+    m_bootstrap.activities = std::move(activities);
+    finishBootstrap();
+}
+
+void ActivitiesCache::finishBootstrap()
+{
+    if (!m_bootstrap.active || !m_bootstrap.currentActivity || !m_bootstrap.activities || !m_bootstrap.serviceVersionChecked) {
+        return;
+    }
+
+    m_bootstrap.active = false;
+    m_reconnecting = false;
+
+    // The current activity is set without publishing it separately,
+    // setAllActivities publishes everything in one snapshot
+    const auto previousActivity = std::exchange(m_currentActivity, *m_bootstrap.currentActivity);
+    setAllActivities(std::move(*m_bootstrap.activities));
+
+    if (previousActivity != m_currentActivity) {
+        notifyCurrentActivityChanged(previousActivity);
+    }
+
+    qCDebug(KAMD_CORELIB) << "Reached a consistent state in" << m_bootstrap.timer.elapsed() << "ms";
+
+    m_bootstrap = Bootstrap();
 }
 
 void ActivitiesCache::updateActivity(const QString &id)
@@ -134,7 +469,7 @@ void ActivitiesCache::updateActivity(const QString &id)
 
     auto call = Manager::self()->activities()->asyncCall(QStringLiteral("ActivityInformation"), id);
 
-    onCallFinished(call, SLOT(setActivityInfoFromReply(QDBusPendingCallWatcher *)));
+    onCallFinished(call, &ActivitiesCache::setActivityInfoFromReply);
 }
 
 void ActivitiesCache::updateActivityState(const QString &id, int state)
@@ -158,10 +493,10 @@ void ActivitiesCache::updateActivityState(const QString &id, int state)
         where->state = state;
 
         if (runningStateChanged) {
-            Q_EMIT runningActivityListChanged();
+            m_pendingRunningListChange = true;
         }
 
-        Q_EMIT activityStateChanged(id, state);
+        scheduleChange(id, StateField);
 
     } else {
         // qFatal("Requested to update the state of a non-existent activity");
@@ -174,10 +509,12 @@ void ActivitiesCache::passInfoFromReply(QDBusPendingCallWatcher *watcher, _Funct
     QDBusPendingReply<_Result> reply = *watcher;
 
     if (!reply.isError()) {
+        // The value is demarshalled only once, and then
+        // moved all the way into the cache storage
         auto replyValue = reply.template argumentAt<0>();
         // qDebug() << "Got some reply" << replyValue;
 
-        ((*this).*f)(replyValue);
+        ((*this).*f)(std::move(replyValue));
     }
 
     watcher->deleteLater();
@@ -192,46 +529,112 @@ void ActivitiesCache::setActivityInfoFromReply(QDBusPendingCallWatcher *watcher)
 void ActivitiesCache::setAllActivitiesFromReply(QDBusPendingCallWatcher *watcher)
 {
     // qDebug() << "reply...";
-    passInfoFromReply<ActivityInfoList>(watcher, &ActivitiesCache::setAllActivities);
+    if (watcher->isError()) {
+        failBootstrap(watcher);
+        return;
+    }
+
+    passInfoFromReply<ActivityInfoList>(watcher, &ActivitiesCache::setBootstrapActivities);
 }
 
 void ActivitiesCache::setCurrentActivityFromReply(QDBusPendingCallWatcher *watcher)
 {
     // qDebug() << "reply...";
+    if (watcher->isError()) {
+        failBootstrap(watcher);
+        return;
+    }
+
     passInfoFromReply<QString>(watcher, &ActivitiesCache::setCurrentActivity);
 }
 
-void ActivitiesCache::setActivityInfo(const ActivityInfo &info)
+void ActivitiesCache::setActivityInfo(ActivityInfo info)
 {
     // qDebug() << "Setting activity info" << info.id;
 
+    // The record is moved into the cache, we need to keep the id
+    const QString id = info.id;
+
     // Are we updating an existing activity, or adding a new one?
-    const auto iter = find(info.id);
-    const auto present = iter != m_activities.end();
+    const auto existing = getInfo<Mutable>(id);
+    const auto present = existing != nullptr;
     bool runningChanged = true;
-    // If there is an activity with the specified id,
-    // we are going to remove it, temporarily.
+
     if (present) {
-        runningChanged = (*iter).state != info.state;
-        m_activities.erase(iter);
-    }
+        runningChanged = existing->state != info.state;
 
-    // Now, we need to find where to insert the activity
-    // and keep the cache sorted by name
-    const auto where = lower_bound(info);
+        ChangedFields fields;
+        if (existing->name != info.name) {
+            fields |= NameField;
+        }
+        if (existing->description != info.description) {
+            fields |= DescriptionField;
+        }
+        if (existing->icon != info.icon) {
+            fields |= IconField;
+        }
+        if (runningChanged) {
+            fields |= StateField;
+        }
+        if (fields) {
+            scheduleChange(info.id, fields);
+        }
+
+        // Only the index needs to be touched, and only
+        // if the activity was renamed
+        if (existing->name != info.name) {
+            m_sortedActivities.erase(indexOf(*existing));
+            m_sortedActivities.insert(lower_bound(info), info.id);
+        }
+
+        *existing = std::move(info);
+
+    } else {
+        // Now, we need to find where to insert the activity
+        // and keep the index sorted by name
+        m_sortedActivities.insert(lower_bound(info), id);
+        m_activities.insert(id, std::move(info));
+    }
 
-    m_activities.insert(where, info);
+    publishSnapshot();
 
     if (present) {
-        Q_EMIT activityChanged(info.id);
+        Q_EMIT activityChanged(id);
+
+        notifySubscribers(id, [](InfoPrivate *subscriber) {
+            subscriber->infoChanged();
+        });
+
     } else {
-        Q_EMIT activityAdded(info.id);
+        Q_EMIT activityAdded(id);
         Q_EMIT activityListChanged();
         if (runningChanged) {
             Q_EMIT runningActivityListChanged();
         }
+
+        notifySubscribers(id, [](InfoPrivate *subscriber) {
+            subscriber->added();
+        });
     }
 }
+
+void ActivitiesCache::setActivityName(const QString &id, const QString &name)
+{
+    auto where = getInfo<Mutable>(id);
+
+    if (where) {
+        // The index is sorted by name, so we need to move the activity
+        ActivityInfo renamed = *where;
+        renamed.name = name;
+
+        m_sortedActivities.erase(indexOf(*where));
+        m_sortedActivities.insert(lower_bound(renamed), id);
+
+        where->name = name;
+        scheduleChange(id, NameField);
+    }
+}
+
 // clang-format off
 #define CREATE_SETTER(WHAT, What)                                              \
     void ActivitiesCache::setActivity##WHAT(const QString &id,                 \
@@ -241,47 +644,241 @@ void ActivitiesCache::setActivityInfo(const ActivityInfo &info)
                                                                                \
         if (where) {                                                           \
             where->What = value;                                               \
-            Q_EMIT activity##WHAT##Changed(id, value);                           \
+            scheduleChange(id, WHAT##Field);                                   \
         }                                                                      \
     }
 // clang-format on
 
-CREATE_SETTER(Name, name)
 CREATE_SETTER(Description, description)
 CREATE_SETTER(Icon, icon)
 
 #undef CREATE_SETTER
 
-void ActivitiesCache::setAllActivities(const ActivityInfoList &_activities)
+void ActivitiesCache::publishSnapshot()
+{
+    // The containers are implicitly shared, so this is cheap. The next
+    // change to the cache makes a copy of them, which is why the changes
+    // to the individual fields are collected and published together
+    std::shared_ptr<const Snapshot> snapshot(new Snapshot{m_activities, m_sortedActivities, m_currentActivity, m_status});
+
+    {
+        // The previous snapshot gets released outside of the lock
+        QMutexLocker lock(&m_snapshotMutex);
+        std::swap(m_snapshot, snapshot);
+    }
+
+    if (m_persistentSnapshot && m_status == Consumer::Running && !m_persistTimer.isActive()) {
+        m_persistTimer.start();
+    }
+}
+
+void ActivitiesCache::scheduleChange(const QString &id, ChangedFields fields)
+{
+    // The changes to the individual fields are published in
+    // the next snapshot, together with their notifications
+    m_pendingChanges[id] |= fields;
+
+    if (!m_changesTimer.isActive()) {
+        m_changesTimer.start();
+    }
+}
+
+void ActivitiesCache::publishChanges()
+{
+    const auto changes = std::exchange(m_pendingChanges, ChangeSet());
+    const bool runningListChanged = std::exchange(m_pendingRunningListChange, false);
+
+    if (!changes.isEmpty()) {
+        publishSnapshot();
+    }
+
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        const auto &id = it.key();
+        const auto fields = it.value();
+        const auto where = getInfo(id);
+
+        // The activity might have been removed in the meantime
+        if (!where) {
+            continue;
+        }
+
+        // Making a copy since the listeners might change the cache
+        const ActivityInfo info = *where;
+
+        if (fields & NameField) {
+            Q_EMIT activityNameChanged(id, info.name);
+            notifySubscribers(id, [name = info.name](InfoPrivate *subscriber) {
+                subscriber->nameChanged(name);
+            });
+        }
+
+        if (fields & DescriptionField) {
+            Q_EMIT activityDescriptionChanged(id, info.description);
+            notifySubscribers(id, [description = info.description](InfoPrivate *subscriber) {
+                subscriber->descriptionChanged(description);
+            });
+        }
+
+        if (fields & IconField) {
+            Q_EMIT activityIconChanged(id, info.icon);
+            notifySubscribers(id, [icon = info.icon](InfoPrivate *subscriber) {
+                subscriber->iconChanged(icon);
+            });
+        }
+
+        if (fields & StateField) {
+            Q_EMIT activityStateChanged(id, info.state);
+            notifySubscribers(id, [state = info.state](InfoPrivate *subscriber) {
+                subscriber->activityStateChanged(state);
+            });
+        }
+    }
+
+    if (runningListChanged) {
+        Q_EMIT runningActivityListChanged();
+    }
+
+    Q_EMIT activitiesChanged(changes);
+}
+
+void ActivitiesCache::setAllActivities(ActivityInfoList activities)
 {
     // qDebug() << "Setting all activities";
 
-    m_activities.clear();
+    // Instead of replacing the whole cache, we are reconciling it
+    // with the received list so that we can report what has changed
+    QSet<QString> received;
+    received.reserve(activities.size());
+    for (const ActivityInfo &info : std::as_const(activities)) {
+        received.insert(info.id);
+    }
+
+    QStringList removed;
+    for (auto it = m_activities.cbegin(); it != m_activities.cend(); ++it) {
+        if (!received.contains(it.key())) {
+            removed << it.key();
+        }
+    }
+    for (const auto &id : std::as_const(removed)) {
+        m_activities.remove(id);
+    }
 
-    const ActivityInfoList activities = _activities;
+    QStringList added;
+    QStringList changed;
+    bool runningListChanged = !removed.isEmpty();
 
-    for (const ActivityInfo &info : activities) {
-        m_activities << info;
+    m_activities.reserve(received.size());
+
+    for (ActivityInfo &info : activities) {
+        const auto existing = getInfo<Mutable>(info.id);
+
+        if (!existing) {
+            const QString id = info.id;
+            added << id;
+            runningListChanged = true;
+            m_activities.insert(id, std::move(info));
+            continue;
+        }
+
+        ChangedFields fields;
+        if (existing->name != info.name) {
+            fields |= NameField;
+        }
+        if (existing->description != info.description) {
+            fields |= DescriptionField;
+        }
+        if (existing->icon != info.icon) {
+            fields |= IconField;
+        }
+        if (existing->state != info.state) {
+            fields |= StateField;
+            runningListChanged = true;
+        }
+
+        if (fields) {
+            changed << info.id;
+            scheduleChange(info.id, fields);
+            *existing = std::move(info);
+        }
     }
 
-    std::sort(m_activities.begin(), m_activities.end(), &infoLessThan);
+    // The index is cheap to rebuild since it contains only the ids
+    const QStringList previousIndex = std::exchange(m_sortedActivities, m_activities.keys());
+
+    std::sort(m_sortedActivities.begin(), m_sortedActivities.end(), [this](const QString &left, const QString &right) {
+        return infoLessThan(*m_activities.constFind(left), *m_activities.constFind(right));
+    });
 
     m_status = Consumer::Running;
+    publishSnapshot();
+
+    // The cache is consistent now, we can notify everyone
+    for (const auto &id : std::as_const(removed)) {
+        Q_EMIT activityRemoved(id);
+        notifySubscribers(id, [](InfoPrivate *subscriber) {
+            subscriber->removed();
+        });
+    }
+
+    for (const auto &id : std::as_const(added)) {
+        Q_EMIT activityAdded(id);
+        notifySubscribers(id, [](InfoPrivate *subscriber) {
+            subscriber->added();
+        });
+    }
+
+    for (const auto &id : std::as_const(changed)) {
+        Q_EMIT activityChanged(id);
+        notifySubscribers(id, [](InfoPrivate *subscriber) {
+            subscriber->infoChanged();
+        });
+    }
+
     Q_EMIT serviceStatusChanged(m_status);
-    Q_EMIT activityListChanged();
+
+    if (previousIndex != m_sortedActivities) {
+        Q_EMIT activityListChanged();
+    }
+
+    if (runningListChanged) {
+        Q_EMIT runningActivityListChanged();
+    }
 }
 
 void ActivitiesCache::setCurrentActivity(const QString &activity)
 {
     // qDebug() << "Setting current activity to" << activity;
 
+    // While bootstrapping, the reply and the change signals can
+    // arrive in any order, the one that arrives last is the newest
+    if (m_bootstrap.active) {
+        m_bootstrap.currentActivity = activity;
+        finishBootstrap();
+        return;
+    }
+
     if (m_currentActivity == activity) {
         return;
     }
 
-    m_currentActivity = activity;
+    const auto previousActivity = std::exchange(m_currentActivity, activity);
+    publishSnapshot();
+
+    notifyCurrentActivityChanged(previousActivity);
+}
+
+void ActivitiesCache::notifyCurrentActivityChanged(const QString &previousActivity)
+{
+    const auto activity = m_currentActivity;
 
     Q_EMIT currentActivityChanged(activity);
+
+    // Only the previous and the new current activity are affected
+    const auto notifyCurrent = [activity](InfoPrivate *subscriber) {
+        subscriber->setCurrentActivity(activity);
+    };
+    notifySubscribers(previousActivity, notifyCurrent);
+    notifySubscribers(activity, notifyCurrent);
 }
 
 } // namespace KActivities
@@ -8,18 +8,27 @@
 #define ACTIVITIES_CACHE_P_H
 
 #include <memory>
+#include <optional>
 
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
 #include <QObject>
+#include <QPointer>
+#include <QStringList>
+#include <QTimer>
 
 #include <common/dbus/org.kde.ActivityManager.Activities.h>
 #include <utils/ptr_to.h>
 
 #include "activities_interface.h"
 #include "consumer.h"
+#include "plasma_activities_export.h"
 
 namespace KActivities
 {
-class ActivitiesCache : public QObject
+// Exported only when the autotests are built, this is not a public API
+class PLASMA_ACTIVITIES_TESTS_EXPORT ActivitiesCache : public QObject
 {
     Q_OBJECT
 
@@ -28,6 +37,41 @@ public:
 
     ~ActivitiesCache() override;
 
+    enum ChangedField {
+        NameField = 0x1,
+        DescriptionField = 0x2,
+        IconField = 0x4,
+        StateField = 0x8,
+    };
+    Q_DECLARE_FLAGS(ChangedFields, ChangedField)
+
+    // The changes are not published one by one, but collected during
+    // one event loop turn (or a configured interval) and published
+    // together as a map from activity ids to the changed fields
+    typedef QHash<QString, ChangedFields> ChangeSet;
+
+    // Info instances register themselves for the activity they represent,
+    // so that the cache notifies only them when that activity changes
+    // instead of broadcasting the change to everyone
+    void subscribe(const QString &id, Info *info);
+    void unsubscribe(const QString &id, Info *info);
+
+    // The cache itself lives in the main thread. Other threads (and the
+    // public getters in general) are reading a frozen copy of it which
+    // gets replaced every time the cache changes
+    struct Snapshot {
+        QHash<QString, ActivityInfo> activities;
+        QStringList sortedActivities;
+        QString currentActivity;
+        Consumer::ServiceStatus status;
+    };
+
+    std::shared_ptr<const Snapshot> snapshot() const
+    {
+        QMutexLocker lock(&m_snapshotMutex);
+        return m_snapshot;
+    }
+
 Q_SIGNALS:
     void activityAdded(const QString &id);
     void activityChanged(const QString &id);
@@ -43,7 +87,11 @@ Q_SIGNALS:
     void activityListChanged();
     void runningActivityListChanged();
 
+    void activitiesChanged(const KActivities::ActivitiesCache::ChangeSet &changes);
+
 private Q_SLOTS:
+    void initialize();
+
     void updateAllActivities();
     void loadOfflineDefaults();
 
@@ -59,12 +107,17 @@ private Q_SLOTS:
     void setActivityDescription(const QString &id, const QString &description);
     void setActivityIcon(const QString &id, const QString &icon);
 
-    void setActivityInfo(const ActivityInfo &info);
-    void setAllActivities(const ActivityInfoList &activities);
+    void setActivityInfo(ActivityInfo info);
+    void setAllActivities(ActivityInfoList activities);
+    void setBootstrapActivities(ActivityInfoList activities);
     void setCurrentActivity(const QString &activity);
 
     void setServiceStatus(bool status);
 
+    void publishChanges();
+
+    void savePersistedSnapshot();
+
 public:
     template<typename _Result, typename _Functor>
     void passInfoFromReply(QDBusPendingCallWatcher *watcher, _Functor f);
@@ -75,45 +128,121 @@ public:
         return comp < 0 || (comp == 0 && info.id < other.id);
     }
 
-    ActivityInfoList::iterator find(const QString &id)
+    // The records are owned by the id-keyed hash, the sorted index
+    // contains only the ids. This means that a lookup by id is cheap,
+    // and that reordering activities does not touch the records
+    QStringList::iterator lower_bound(const ActivityInfo &info)
     {
-        return std::find_if(m_activities.begin(), m_activities.end(), [&id](const ActivityInfo &info) {
-            return info.id == id;
+        return std::lower_bound(m_sortedActivities.begin(), m_sortedActivities.end(), info, [this](const QString &id, const ActivityInfo &info) {
+            return infoLessThan(*m_activities.constFind(id), info);
         });
     }
 
-    ActivityInfoList::iterator lower_bound(const ActivityInfo &info)
+    // Returns the position of an existing activity in the sorted index
+    QStringList::iterator indexOf(const ActivityInfo &info)
     {
-        return std::lower_bound(m_activities.begin(), m_activities.end(), info, &infoLessThan);
+        const auto where = lower_bound(info);
+        return (where != m_sortedActivities.end() && *where == info.id) ? where : m_sortedActivities.end();
     }
 
     template<int Policy = kamd::utils::Const>
     inline typename kamd::utils::ptr_to<ActivityInfo, Policy>::type getInfo(const QString &id)
     {
-        const auto where = find(id);
-
-        if (where != m_activities.end()) {
-            return &(*where);
+        // The hash is shared with the published snapshot, looking
+        // up a record only for reading must not make a deep copy of it
+        if constexpr (Policy == kamd::utils::Const) {
+            const auto where = m_activities.constFind(id);
+            return where != m_activities.cend() ? &(*where) : nullptr;
+
+        } else {
+            const auto where = m_activities.find(id);
+            return where != m_activities.end() ? &(*where) : nullptr;
         }
+    }
+
+    template<typename Handler>
+    void notifySubscribers(const QString &id, Handler handler);
+
+    void scheduleChange(const QString &id, ChangedFields fields);
+
+    void publishSnapshot();
 
-        return nullptr;
+    static QString persistedSnapshotPath();
+    void loadPersistedSnapshot();
+
+    void finishBootstrap();
+    void notifyCurrentActivityChanged(const QString &previousActivity);
+
+    void onCallFinished(const QDBusPendingCall &call, void (ActivitiesCache::*slot)(QDBusPendingCallWatcher *))
+    {
+        auto watcher = new QDBusPendingCallWatcher(call, this);
+
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, slot);
     }
 
-    template<typename TargetSlot>
-    void onCallFinished(QDBusPendingCall &call, TargetSlot slot)
+    // The replies that belong to an earlier bootstrap are dropped
+    void onBootstrapCallFinished(const QDBusPendingCall &call, void (ActivitiesCache::*slot)(QDBusPendingCallWatcher *))
     {
         auto watcher = new QDBusPendingCallWatcher(call, this);
 
-        connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher *)), this, slot);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, slot, generation = m_bootstrap.generation](QDBusPendingCallWatcher *watcher) {
+            if (isCurrentBootstrap(generation)) {
+                (this->*slot)(watcher);
+            } else {
+                watcher->deleteLater();
+            }
+        });
+    }
+
+    bool isCurrentBootstrap(quint64 generation) const
+    {
+        return m_bootstrap.active && m_bootstrap.generation == generation;
     }
 
+    void failBootstrap(QDBusPendingCallWatcher *watcher);
+
     ActivitiesCache();
 
-    QList<ActivityInfo> m_activities;
+    QHash<QString, ActivityInfo> m_activities;
+    QStringList m_sortedActivities;
     QString m_currentActivity;
     Consumer::ServiceStatus m_status;
+
+    // The replies to the startup queries, the cache switches
+    // to the Running state only when all of them arrive
+    struct Bootstrap {
+        bool active = false;
+        quint64 generation = 0;
+        std::optional<QString> currentActivity;
+        std::optional<ActivityInfoList> activities;
+        bool serviceVersionChecked = false;
+        QElapsedTimer timer;
+    };
+    Bootstrap m_bootstrap;
+    quint64 m_bootstrapGeneration = 0;
+
+    ChangeSet m_pendingChanges;
+    bool m_pendingRunningListChange;
+    QTimer m_changesTimer;
+    QTimer m_persistTimer;
+    const bool m_persistentSnapshot;
+
+    QTimer m_reconnectTimer;
+    bool m_reconnecting;
+
+    // Info objects can be created in other threads, so the registry
+    // needs to be guarded. The pointers are not tracked by QPointer
+    // which is not safe to use across threads, each Info removes
+    // itself from the registry when it gets destroyed
+    QMutex m_subscribersMutex;
+    QHash<QString, QList<Info *>> m_subscribers;
+
+    mutable QMutex m_snapshotMutex;
+    std::shared_ptr<const Snapshot> m_snapshot;
 };
 
 } // namespace KActivities
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KActivities::ActivitiesCache::ChangedFields)
+
 #endif /* ACTIVITIES_CACHE_P_H */
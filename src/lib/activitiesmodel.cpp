@@ -16,6 +16,7 @@
 #include <QFutureWatcher>
 #include <QHash>
 #include <QModelIndex>
+#include <QSet>
 
 // Local
 #include "utils/remove_if.h"
@@ -77,35 +78,39 @@ inline ActivityPosition<_Container> activityPosition(const _Container &container
 }
 
 /**
- * Notifies the model that an activity was updated
+ * Returns the model roles affected by the changed activity fields
  */
-template<typename _Model, typename _Container>
-inline void emitActivityUpdated(_Model *model, const _Container &container, const QString &activity, int role)
+inline QList<int> changedRoles(ActivitiesCache::ChangedFields fields)
 {
-    auto position = Private::activityPosition(container, activity);
+    QList<int> roles;
 
-    if (position) {
-        Q_EMIT model->q->dataChanged(model->q->index(position.index),
-                                     model->q->index(position.index),
-                                     role == Qt::DecorationRole ? QList<int>{role, ActivitiesModel::ActivityIconSource} : QList<int>{role});
+    if (fields & ActivitiesCache::NameField) {
+        roles << Qt::DisplayRole << ActivitiesModel::ActivityName;
+    }
+    if (fields & ActivitiesCache::DescriptionField) {
+        roles << ActivitiesModel::ActivityDescription;
+    }
+    if (fields & ActivitiesCache::IconField) {
+        roles << Qt::DecorationRole << ActivitiesModel::ActivityIconSource;
+    }
+    if (fields & ActivitiesCache::StateField) {
+        roles << ActivitiesModel::ActivityState;
     }
-}
 
-/**
- * Notifies the model that an activity was updated
- */
-template<typename _Model, typename _Container>
-inline void emitActivityUpdated(_Model *model, const _Container &container, QObject *activityInfo, int role)
-{
-    const auto activity = static_cast<Info *>(activityInfo);
-    emitActivityUpdated(model, container, activity->id(), role);
+    return roles;
 }
-
 }
 
 ActivitiesModelPrivate::ActivitiesModelPrivate(ActivitiesModel *parent)
-    : q(parent)
+    : cache(ActivitiesCache::self())
+    , knownActivities(InfoPtrComparator{this})
+    , shownActivities(InfoPtrComparator{this})
+    , q(parent)
 {
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    collator.setNumericMode(true);
+
+    connect(cache.get(), &ActivitiesCache::activitiesChanged, this, &ActivitiesModelPrivate::onActivitiesChanged);
 }
 
 ActivitiesModel::ActivitiesModel(QObject *parent)
@@ -174,16 +179,37 @@ void ActivitiesModelPrivate::setServiceStatus(Consumer::ServiceStatus)
 
 void ActivitiesModelPrivate::replaceActivities(const QStringList &activities)
 {
-    q->beginResetModel();
-
-    knownActivities.clear();
-    shownActivities.clear();
+    // This is called on every service status change, including the
+    // reconnects. Resetting the model would make the views lose their
+    // selection, so only the rows that differ from the list are touched
+    const QSet<QString> newActivities(activities.cbegin(), activities.cend());
+
+    QStringList removedActivities;
+    for (const auto &info : std::as_const(knownActivities)) {
+        if (!newActivities.contains(info->id())) {
+            removedActivities << info->id();
+        }
+    }
 
-    for (const QString &activity : activities) {
-        onActivityAdded(activity, false);
+    for (const auto &id : std::as_const(removedActivities)) {
+        onActivityRemoved(id);
     }
 
-    q->endResetModel();
+    for (const QString &id : activities) {
+        const auto info = registerActivity(id);
+
+        // The activity could have been renamed before the change
+        // reached us, only those need to be moved
+        if (sortKeys.constFind(info.get())->name != info->name()) {
+            repositionActivity(id);
+        }
+
+        if (Private::matchingState(info, shownStates)) {
+            showActivity(info, true);
+        } else {
+            hideActivity(id);
+        }
+    }
 }
 
 void ActivitiesModelPrivate::onActivityAdded(const QString &id, bool notifyClients)
@@ -203,9 +229,11 @@ void ActivitiesModelPrivate::onCurrentActivityChanged(const QString &id)
 {
     Q_UNUSED(id);
 
-    for (const auto &activity : shownActivities) {
-        Private::emitActivityUpdated(this, shownActivities, activity->id(), ActivitiesModel::ActivityIsCurrent);
+    if (shownActivities.isEmpty()) {
+        return;
     }
+
+    Q_EMIT q->dataChanged(q->index(0), q->index(shownActivities.size() - 1), {ActivitiesModel::ActivityIsCurrent});
 }
 
 ActivitiesModelPrivate::InfoPtr ActivitiesModelPrivate::registerActivity(const QString &id)
@@ -216,15 +244,11 @@ ActivitiesModelPrivate::InfoPtr ActivitiesModelPrivate::registerActivity(const Q
         return *(position.iterator);
 
     } else {
-        auto activityInfo = std::make_shared<Info>(id);
-
-        auto ptr = activityInfo.get();
-
-        connect(ptr, &Info::nameChanged, this, &ActivitiesModelPrivate::onActivityNameChanged);
-        connect(ptr, &Info::descriptionChanged, this, &ActivitiesModelPrivate::onActivityDescriptionChanged);
-        connect(ptr, &Info::iconChanged, this, &ActivitiesModelPrivate::onActivityIconChanged);
-        connect(ptr, &Info::stateChanged, this, &ActivitiesModelPrivate::onActivityStateChanged);
+        // The changes are not tracked through the Info instance,
+        // but through the change sets published by the cache
+        auto activityInfo = Info::shared(id);
 
+        updateSortKey(activityInfo);
         knownActivities.insert(InfoPtr(activityInfo));
 
         return activityInfo;
@@ -242,10 +266,57 @@ void ActivitiesModelPrivate::unregisterActivity(const QString &id)
             q->endRemoveRows();
         }
 
+        sortKeys.remove(position.iterator->get());
         knownActivities.removeAt(position.index);
     }
 }
 
+void ActivitiesModelPrivate::updateSortKey(const InfoPtr &activityInfo)
+{
+    const auto name = activityInfo->name();
+    sortKeys.insert(activityInfo.get(), SortKey{name, collator.sortKey(name)});
+}
+
+void ActivitiesModelPrivate::repositionActivity(const QString &id)
+{
+    // The flat sets need to be kept sorted, so we are taking the
+    // renamed activity out, updating its key and putting it back
+    const auto known = Private::activityPosition(knownActivities, id);
+
+    if (!known) {
+        return;
+    }
+
+    const auto activityInfo = knownActivities.takeAt(known.index);
+    updateSortKey(activityInfo);
+    knownActivities.insert(activityInfo);
+
+    const auto shown = Private::activityPosition(shownActivities, id);
+
+    if (!shown) {
+        return;
+    }
+
+    // The rest of the list is still sorted, looking for the new row
+    // on both sides of the old one, as if it was not there
+    const int oldRow = shown.index;
+    const auto begin = shownActivities.cbegin();
+    const auto oldPosition = begin + oldRow;
+    const auto &lessThan = shownActivities.lessThan();
+
+    const auto before = std::lower_bound(begin, oldPosition, activityInfo, lessThan);
+    const int newRow =
+        before != oldPosition ? before - begin : std::lower_bound(oldPosition + 1, shownActivities.cend(), activityInfo, lessThan) - begin - 1;
+
+    if (oldRow == newRow) {
+        return;
+    }
+
+    q->beginMoveRows(QModelIndex(), oldRow, oldRow, QModelIndex(), newRow > oldRow ? newRow + 1 : newRow);
+    shownActivities.move(oldRow, newRow);
+    q->endMoveRows();
+}
+
 void ActivitiesModelPrivate::showActivity(InfoPtr activityInfo, bool notifyClients)
 {
     // Should it really be shown?
@@ -254,7 +325,7 @@ void ActivitiesModelPrivate::showActivity(InfoPtr activityInfo, bool notifyClien
     }
 
     // Is it already shown?
-    if (std::binary_search(shownActivities.cbegin(), shownActivities.cend(), activityInfo, InfoPtrComparator())) {
+    if (std::binary_search(shownActivities.cbegin(), shownActivities.cend(), activityInfo, shownActivities.lessThan())) {
         return;
     }
 
@@ -267,14 +338,18 @@ void ActivitiesModelPrivate::showActivity(InfoPtr activityInfo, bool notifyClien
 
     const auto activityInfoPtr = *(registeredPosition.iterator);
 
-    // In C++17, this would be:
-    // const auto [iterator, index, found] = shownActivities.insert(...);
-    const auto _result = shownActivities.insert(activityInfoPtr);
-    // const auto iterator = std::get<0>(_result);
-    const auto index = std::get<1>(_result);
+    // The views need to be told where the row is going to be
+    // before it gets there
+    const int index =
+        std::lower_bound(shownActivities.cbegin(), shownActivities.cend(), activityInfoPtr, shownActivities.lessThan()) - shownActivities.cbegin();
 
     if (notifyClients) {
         q->beginInsertRows(QModelIndex(), index, index);
+    }
+
+    shownActivities.insert(activityInfoPtr);
+
+    if (notifyClients) {
         q->endInsertRows();
     }
 }
@@ -290,38 +365,62 @@ void ActivitiesModelPrivate::hideActivity(const QString &id)
     }
 }
 
-// clang-format off
-#define CREATE_SIGNAL_EMITTER(What,Role)                                      \
-    void ActivitiesModelPrivate::onActivity##What##Changed(const QString &)    \
-    {                                                                          \
-        Private::emitActivityUpdated(this, shownActivities, sender(), Role);   \
+void ActivitiesModelPrivate::onActivitiesChanged(const ActivitiesCache::ChangeSet &changes)
+{
+    // Renamed activities might need to change their position
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        if (it.value() & ActivitiesCache::NameField) {
+            repositionActivity(it.key());
+        }
     }
-// clang-format on
 
-CREATE_SIGNAL_EMITTER(Name, Qt::DisplayRole)
-CREATE_SIGNAL_EMITTER(Description, ActivitiesModel::ActivityDescription)
-CREATE_SIGNAL_EMITTER(Icon, Qt::DecorationRole)
+    // If we are filtering on the state, the state changes
+    // can show or hide some of the activities
+    if (!shownStates.empty()) {
+        for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+            if (!(it.value() & ActivitiesCache::StateField)) {
+                continue;
+            }
 
-#undef CREATE_SIGNAL_EMITTER
+            const auto position = Private::activityPosition(knownActivities, it.key());
 
-void ActivitiesModelPrivate::onActivityStateChanged(Info::State state)
-{
-    if (shownStates.empty()) {
-        Private::emitActivityUpdated(this, shownActivities, sender(), ActivitiesModel::ActivityState);
+            if (!position) {
+                continue;
+            }
 
-    } else {
-        auto info = findActivity(sender());
+            const auto info = *(position.iterator);
 
-        if (!info) {
-            return;
+            if (shownStates.contains(info->state())) {
+                showActivity(info, true);
+            } else {
+                hideActivity(info->id());
+            }
         }
+    }
 
-        if (shownStates.contains(state)) {
-            showActivity(info, true);
-        } else {
-            hideActivity(info->id());
+    // Notifying the views with a single range that
+    // covers all the changed activities
+    int firstRow = shownActivities.size();
+    int lastRow = -1;
+    ActivitiesCache::ChangedFields fields;
+
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        const auto position = Private::activityPosition(shownActivities, it.key());
+
+        if (!position) {
+            continue;
         }
+
+        firstRow = qMin(firstRow, int(position.index));
+        lastRow = qMax(lastRow, int(position.index));
+        fields |= it.value();
+    }
+
+    if (lastRow < 0) {
+        return;
     }
+
+    Q_EMIT q->dataChanged(q->index(firstRow), q->index(lastRow), Private::changedRoles(fields));
 }
 
 void ActivitiesModel::setShownStates(const QList<Info::State> &states)
@@ -391,19 +490,6 @@ QVariant ActivitiesModel::headerData(int section, Qt::Orientation orientation, i
     return QVariant();
 }
 
-ActivitiesModelPrivate::InfoPtr ActivitiesModelPrivate::findActivity(QObject *ptr) const
-{
-    auto info = std::find_if(knownActivities.cbegin(), knownActivities.cend(), [ptr](const InfoPtr &info) {
-        return ptr == info.get();
-    });
-
-    if (info == knownActivities.end()) {
-        return nullptr;
-    } else {
-        return *info;
-    }
-}
-
 } // namespace KActivities
 
 #include "moc_activitiesmodel.cpp"
@@ -9,11 +9,13 @@
 
 #include "activitiesmodel.h"
 
+#include "activitiescache_p.h"
 #include "consumer.h"
 
 #include "utils/qflatset.h"
 
 #include <QCollator>
+#include <QHash>
 
 namespace KActivities
 {
@@ -24,10 +26,7 @@ public:
     ActivitiesModelPrivate(ActivitiesModel *parent);
 
 public Q_SLOTS:
-    void onActivityNameChanged(const QString &name);
-    void onActivityDescriptionChanged(const QString &description);
-    void onActivityIconChanged(const QString &icon);
-    void onActivityStateChanged(KActivities::Info::State state);
+    void onActivitiesChanged(const KActivities::ActivitiesCache::ChangeSet &changes);
 
     void replaceActivities(const QStringList &activities);
     void onActivityAdded(const QString &id, bool notifyClients = true);
@@ -38,17 +37,34 @@ public Q_SLOTS:
 
 public:
     KActivities::Consumer activities;
+    std::shared_ptr<ActivitiesCache> cache;
     QList<Info::State> shownStates;
 
     typedef std::shared_ptr<Info> InfoPtr;
 
+    // Building the collation key is expensive, so it is done once
+    // per activity (and again when it gets renamed) instead of
+    // on every comparison. The name the key was built from tells
+    // us whether the activity has been renamed since
+    QCollator collator;
+    struct SortKey {
+        QString name;
+        QCollatorSortKey key;
+    };
+    QHash<const Info *, SortKey> sortKeys;
+
+    void updateSortKey(const InfoPtr &activityInfo);
+
     struct InfoPtrComparator {
+        const ActivitiesModelPrivate *d;
+
         bool operator()(const InfoPtr &left, const InfoPtr &right) const
         {
-            QCollator c;
-            c.setCaseSensitivity(Qt::CaseInsensitive);
-            c.setNumericMode(true);
-            int rc = c.compare(left->name(), right->name());
+            const auto leftKey = d->sortKeys.constFind(left.get());
+            const auto rightKey = d->sortKeys.constFind(right.get());
+            Q_ASSERT(leftKey != d->sortKeys.cend() && rightKey != d->sortKeys.cend());
+
+            int rc = leftKey->key.compare(rightKey->key);
             if (rc == 0) {
                 return left->id() < right->id();
             }
@@ -64,8 +80,7 @@ public:
     void showActivity(InfoPtr activityInfo, bool notifyClients);
     void hideActivity(const QString &id);
     void backgroundsUpdated(const QStringList &activities);
-
-    InfoPtr findActivity(QObject *ptr) const;
+    void repositionActivity(const QString &id);
 
     ActivitiesModel *const q;
 };
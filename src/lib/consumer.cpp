@@ -44,18 +44,20 @@ Consumer::~Consumer() = default;
 
 QString Consumer::currentActivity() const
 {
-    return d->cache->m_currentActivity;
+    return d->cache->snapshot()->currentActivity;
 }
 
 QStringList Consumer::activities(Info::State state) const
 {
+    const auto snapshot = d->cache->snapshot();
+
     QStringList result;
 
-    result.reserve(d->cache->m_activities.size());
+    result.reserve(snapshot->sortedActivities.size());
 
-    for (const auto &info : std::as_const(d->cache->m_activities)) {
-        if (info.state == state) {
-            result << info.id;
+    for (const auto &id : std::as_const(snapshot->sortedActivities)) {
+        if (snapshot->activities.constFind(id)->state == state) {
+            result << id;
         }
     }
 
@@ -64,26 +66,21 @@ QStringList Consumer::activities(Info::State state) const
 
 QStringList Consumer::activities() const
 {
-    QStringList result;
-
-    result.reserve(d->cache->m_activities.size());
-
-    for (const auto &info : std::as_const(d->cache->m_activities)) {
-        result << info.id;
-    }
-
-    return result;
+    return d->cache->snapshot()->sortedActivities;
 }
 
 QStringList Consumer::runningActivities() const
 {
+    const auto snapshot = d->cache->snapshot();
+
     QStringList result;
 
-    result.reserve(d->cache->m_activities.size());
+    result.reserve(snapshot->sortedActivities.size());
 
-    for (const auto &info : std::as_const(d->cache->m_activities)) {
-        if (info.state == Info::Running || info.state == Info::Stopping) {
-            result << info.id;
+    for (const auto &id : std::as_const(snapshot->sortedActivities)) {
+        const auto state = snapshot->activities.constFind(id)->state;
+        if (state == Info::Running || state == Info::Stopping) {
+            result << id;
         }
     }
 
@@ -92,7 +89,7 @@ QStringList Consumer::runningActivities() const
 
 Consumer::ServiceStatus Consumer::serviceStatus()
 {
-    return d->cache->m_status;
+    return d->cache->snapshot()->status;
 }
 
 } // namespace KActivities
@@ -14,23 +14,41 @@ namespace KActivities
 {
 class ControllerPrivate
 {
+public:
+    ControllerPrivate()
+        : callTimeout(-1)
+    {
+    }
+
+    int callTimeout;
 };
 
 Controller::Controller(QObject *parent)
     : Consumer(parent)
+    , d(new ControllerPrivate())
 {
 }
 
 Controller::~Controller() = default;
 
+void Controller::setCallTimeout(int msec)
+{
+    d->callTimeout = msec;
+}
+
+int Controller::callTimeout() const
+{
+    return d->callTimeout;
+}
+
 // clang-format off
 #define CREATE_SETTER(What)                                                    \
     QFuture<void> Controller::setActivity##What(const QString &id,             \
                                                 const QString &value)          \
     {                                                                          \
         return Manager::isServiceRunning()                                     \
-                   ? DBusFuture::asyncCall<void>(                              \
-                         Manager::activities(),                                \
+                   ? DBusFuture::asyncCallWithTimeout<void>(                   \
+                         Manager::activities(), d->callTimeout,                \
                          QString::fromLatin1("SetActivity" #What), id, value)  \
                    : DBusFuture::fromVoid();                                   \
     }
@@ -48,7 +66,7 @@ QFuture<bool> Controller::setCurrentActivity(const QString &id)
     //            "You can not set a non-existent activity to be the current");
 
     // return Manager::activities()->SetCurrentActivity(id);
-    return Manager::isServiceRunning() ? DBusFuture::asyncCall<bool>(Manager::activities(), QStringLiteral("SetCurrentActivity"), id)
+    return Manager::isServiceRunning() ? DBusFuture::asyncCallWithTimeout<bool>(Manager::activities(), d->callTimeout, QStringLiteral("SetCurrentActivity"), id)
                                        : DBusFuture::fromValue(false);
 }
 
@@ -57,7 +75,7 @@ QFuture<QString> Controller::addActivity(const QString &name)
     Q_ASSERT_X(!name.isEmpty(), "Controller::addActivity", "The activity name can not be an empty string");
 
     // return Manager::activities()->AddActivity(name);
-    return Manager::isServiceRunning() ? DBusFuture::asyncCall<QString>(Manager::activities(), QStringLiteral("AddActivity"), name)
+    return Manager::isServiceRunning() ? DBusFuture::asyncCallWithTimeout<QString>(Manager::activities(), d->callTimeout, QStringLiteral("AddActivity"), name)
                                        : DBusFuture::fromValue(QString());
 }
 
@@ -67,7 +85,8 @@ QFuture<void> Controller::removeActivity(const QString &id)
     //            "You can not remove a non-existent activity");
 
     // Manager::activities()->RemoveActivity(id);
-    return Manager::isServiceRunning() ? DBusFuture::asyncCall<void>(Manager::activities(), QStringLiteral("RemoveActivity"), id) : DBusFuture::fromVoid();
+    return Manager::isServiceRunning() ? DBusFuture::asyncCallWithTimeout<void>(Manager::activities(), d->callTimeout, QStringLiteral("RemoveActivity"), id)
+                                       : DBusFuture::fromVoid();
 }
 
 QFuture<void> Controller::stopActivity(const QString &id)
@@ -76,7 +95,8 @@ QFuture<void> Controller::stopActivity(const QString &id)
     //            "You can not stop a non-existent activity");
 
     // Manager::activities()->StopActivity(id);
-    return Manager::isServiceRunning() ? DBusFuture::asyncCall<void>(Manager::activities(), QStringLiteral("StopActivity"), id) : DBusFuture::fromVoid();
+    return Manager::isServiceRunning() ? DBusFuture::asyncCallWithTimeout<void>(Manager::activities(), d->callTimeout, QStringLiteral("StopActivity"), id)
+                                       : DBusFuture::fromVoid();
 }
 
 QFuture<void> Controller::startActivity(const QString &id)
@@ -85,17 +105,20 @@ QFuture<void> Controller::startActivity(const QString &id)
     //            "You can not start an non-existent activity");
 
     // Manager::activities()->StartActivity(id);
-    return Manager::isServiceRunning() ? DBusFuture::asyncCall<void>(Manager::activities(), QStringLiteral("StartActivity"), id) : DBusFuture::fromVoid();
+    return Manager::isServiceRunning() ? DBusFuture::asyncCallWithTimeout<void>(Manager::activities(), d->callTimeout, QStringLiteral("StartActivity"), id)
+                                       : DBusFuture::fromVoid();
 }
 
 QFuture<void> Controller::previousActivity()
 {
-    return Manager::isServiceRunning() ? DBusFuture::asyncCall<void>(Manager::activities(), QStringLiteral("PreviousActivity")) : DBusFuture::fromVoid();
+    return Manager::isServiceRunning() ? DBusFuture::asyncCallWithTimeout<void>(Manager::activities(), d->callTimeout, QStringLiteral("PreviousActivity"))
+                                       : DBusFuture::fromVoid();
 }
 
 QFuture<void> Controller::nextActivity()
 {
-    return Manager::isServiceRunning() ? DBusFuture::asyncCall<void>(Manager::activities(), QStringLiteral("NextActivity")) : DBusFuture::fromVoid();
+    return Manager::isServiceRunning() ? DBusFuture::asyncCallWithTimeout<void>(Manager::activities(), d->callTimeout, QStringLiteral("NextActivity"))
+                                       : DBusFuture::fromVoid();
 }
 
 } // namespace KActivities
@@ -26,9 +26,13 @@ class ControllerPrivate;
  * the activities.
  *
  * @note The QFuture objects returned by these methods are not thread-based,
- * you can not call synchronous methods like waitForFinished, cancel, pause on
+ * you can not call synchronous methods like waitForFinished or pause on
  * them. You need either to register watchers to check when those have finished,
  * or to check whether they are ready from time to time manually.
+ * Canceling them is supported, the reply to a canceled call is ignored.
+ *
+ * If the service does not reply in time (see setCallTimeout), the future
+ * finishes without a result.
  *
  * @see Consumer for info about activities
  *
@@ -45,6 +49,23 @@ public:
 
     ~Controller() override;
 
+    /**
+     * Sets how long the service has to reply to the calls made
+     * through this controller, in milliseconds. A negative value means
+     * the default timeout, which is 10 seconds unless it is changed for
+     * the whole application through the "org.kde.KActivities.core.callTimeout"
+     * property of the application object.
+     * @since 6.3
+     */
+    void setCallTimeout(int msec);
+
+    /**
+     * @returns the timeout for the calls made through this controller,
+     * or a negative value if the default one is used
+     * @since 6.3
+     */
+    int callTimeout() const;
+
     /**
      * Sets the name of the specified activity
      * @param id id of the activity
@@ -10,7 +10,12 @@
 
 #include "utils/dbusfuture_p.h"
 
+#include <QCoreApplication>
 #include <QFileSystemWatcher>
+#include <QHash>
+#include <QThread>
+
+#include <mutex>
 
 namespace KActivities
 {
@@ -24,26 +29,22 @@ InfoPrivate::InfoPrivate(Info *info, const QString &activity)
 }
 
 // clang-format off
-// Filters out signals for only this activity
 #define IMPLEMENT_SIGNAL_HANDLER(INTERNAL)                                     \
-    void InfoPrivate::INTERNAL(const QString &_id) const                       \
-    {   if (id == _id) Q_EMIT q->INTERNAL(); }
+    void InfoPrivate::INTERNAL() const                                         \
+    {                                                                          \
+        Q_EMIT q->INTERNAL();                                                  \
+    }
 
 IMPLEMENT_SIGNAL_HANDLER(added)
 IMPLEMENT_SIGNAL_HANDLER(removed)
-IMPLEMENT_SIGNAL_HANDLER(started)
-IMPLEMENT_SIGNAL_HANDLER(stopped)
 IMPLEMENT_SIGNAL_HANDLER(infoChanged)
 
 #undef IMPLEMENT_SIGNAL_HANDLER
 
 #define IMPLEMENT_SIGNAL_HANDLER(INTERNAL)                                     \
-    void InfoPrivate::INTERNAL##Changed(const QString &_id,                    \
-                                        const QString &val) const              \
+    void InfoPrivate::INTERNAL##Changed(const QString &val) const              \
     {                                                                          \
-        if (id == _id) {                                                       \
-            Q_EMIT q->INTERNAL##Changed(val);                                    \
-        }                                                                      \
+        Q_EMIT q->INTERNAL##Changed(val);                                      \
     }
 
 IMPLEMENT_SIGNAL_HANDLER(name)
@@ -51,19 +52,17 @@ IMPLEMENT_SIGNAL_HANDLER(description)
 IMPLEMENT_SIGNAL_HANDLER(icon)
 
 #undef IMPLEMENT_SIGNAL_HANDLER
+// clang-format on
 
-void InfoPrivate::activityStateChanged(const QString &idChanged,
-                                       int newState) const
+void InfoPrivate::activityStateChanged(int newState) const
 {
-    if (idChanged == id) {
-        auto state = static_cast<Info::State>(newState);
-        Q_EMIT q->stateChanged(state);
-
-        if (state == KActivities::Info::Stopped) {
-            Q_EMIT q->stopped();
-        } else if (state == KActivities::Info::Running) {
-            Q_EMIT q->started();
-        }
+    auto state = static_cast<Info::State>(newState);
+    Q_EMIT q->stateChanged(state);
+
+    if (state == KActivities::Info::Stopped) {
+        Q_EMIT q->stopped();
+    } else if (state == KActivities::Info::Running) {
+        Q_EMIT q->started();
     }
 }
 
@@ -90,35 +89,61 @@ Info::Info(const QString &activity, QObject *parent)
     , d(new InfoPrivate(this, activity))
 {
     // qDebug() << "Created an instance of Info: " << (void*)this;
-#define PASS_SIGNAL_HANDLER(SIGNAL_NAME,SLOT_NAME)                            \
-    connect(d->cache.get(),  SIGNAL(SIGNAL_NAME(QString)),                     \
-            this,            SLOT(SLOT_NAME(QString)));
-
-    PASS_SIGNAL_HANDLER(activityAdded,added)
-    PASS_SIGNAL_HANDLER(activityRemoved,removed)
-    // PASS_SIGNAL_HANDLER(started)
-    // PASS_SIGNAL_HANDLER(stopped)
-    PASS_SIGNAL_HANDLER(activityChanged,infoChanged)
-#undef PASS_SIGNAL_HANDLER
-
-#define PASS_SIGNAL_HANDLER(SIGNAL_NAME,SLOT_NAME,TYPE)                      \
-    connect(d->cache.get(),  SIGNAL(SIGNAL_NAME(QString,TYPE)),               \
-            this,            SLOT(SLOT_NAME(QString,TYPE)));                  \
-
-    PASS_SIGNAL_HANDLER(activityStateChanged,activityStateChanged,int);
-    PASS_SIGNAL_HANDLER(activityNameChanged,nameChanged,QString);
-    PASS_SIGNAL_HANDLER(activityDescriptionChanged,descriptionChanged,QString);
-    PASS_SIGNAL_HANDLER(activityIconChanged,iconChanged,QString);
-// clang-format on
-#undef PASS_SIGNAL_HANDLER
-    connect(d->cache.get(), SIGNAL(currentActivityChanged(QString)), this, SLOT(setCurrentActivity(QString)));
 
-    d->isCurrent = (d->cache.get()->m_currentActivity == activity);
+    // The cache will notify us only about the changes
+    // to the activity we are interested in
+    d->cache->subscribe(activity, this);
+
+    d->isCurrent = (d->cache->snapshot()->currentActivity == activity);
 }
 
 Info::~Info()
 {
     // qDebug() << "Deleted an instance of Info: " << (void*)this;
+
+    // This needs to come first, the cache might be
+    // notifying us from a different thread
+    d->cache->unsubscribe(d->id, this);
+}
+
+std::shared_ptr<Info> Info::shared(const QString &activity)
+{
+    static QHash<QString, std::weak_ptr<Info>> s_instances;
+    static std::mutex singleton;
+    std::lock_guard<std::mutex> singleton_lock(singleton);
+
+    auto result = s_instances[activity].lock();
+
+    if (!result) {
+        // The instance is shared between all the threads, so it lives in
+        // the main thread and does not depend on the event loop of the
+        // thread that happened to request it first
+        auto info = new Info(activity);
+        info->moveToThread(QCoreApplication::instance()->thread());
+
+        result.reset(info, [activity](Info *info) {
+            {
+                std::lock_guard<std::mutex> singleton_lock(singleton);
+
+                // Somebody might have requested a new instance
+                // while this one was being released
+                const auto where = s_instances.constFind(activity);
+                if (where != s_instances.cend() && where->expired()) {
+                    s_instances.erase(where);
+                }
+            }
+
+            if (info->thread() == QThread::currentThread()) {
+                delete info;
+            } else {
+                info->deleteLater();
+            }
+        });
+
+        s_instances[activity] = result;
+    }
+
+    return result;
 }
 
 bool Info::isValid() const
@@ -144,13 +169,15 @@ bool Info::isCurrent() const
 
 Info::State Info::state() const
 {
-    if (d->cache->m_status == Consumer::Unknown) {
+    const auto snapshot = d->cache->snapshot();
+
+    if (snapshot->status == Consumer::Unknown) {
         return Info::Unknown;
     }
 
-    auto info = d->cache->getInfo(d->id);
+    const auto info = snapshot->activities.constFind(d->id);
 
-    if (!info) {
+    if (info == snapshot->activities.cend()) {
         return Info::Invalid;
     }
 
@@ -162,40 +189,53 @@ void InfoPrivate::setServiceStatus(Consumer::ServiceStatus status) const
     switch (status) {
     case Consumer::NotRunning:
     case Consumer::Unknown:
-        activityStateChanged(id, Info::Unknown);
+        activityStateChanged(Info::Unknown);
         break;
 
     default:
-        activityStateChanged(id, q->state());
+        activityStateChanged(q->state());
         break;
     }
 }
 
 Info::Availability Info::availability() const
 {
-    Availability result = Nothing;
+    const auto snapshot = d->cache->snapshot();
 
-    if (!Manager::isServiceRunning()) {
-        return result;
+    if (snapshot->status != Consumer::Running || !snapshot->activities.contains(d->id)) {
+        return Nothing;
     }
 
-    if (Manager::activities()->ListActivities().value().contains(d->id)) {
-        result = BasicInfo;
+    return Manager::self()->isFeatureOperational(QStringLiteral("resources/linking")) ? Everything : BasicInfo;
+}
 
-        if (Manager::features()->IsFeatureOperational(QStringLiteral("resources/linking"))) {
-            result = Everything;
-        }
+QFuture<Info::Availability> Info::availabilityFuture() const
+{
+    if (!Manager::isServiceRunning()) {
+        return DBusFuture::fromValue(Nothing);
     }
 
-    return result;
+    return DBusFuture::fromReply(Manager::activities()->ListActivities())
+        .then(Manager::self(),
+              [id = d->id](const QFuture<QStringList> &activities) {
+                  if (activities.resultCount() == 0 || !activities.result().contains(id)) {
+                      return DBusFuture::fromValue(Nothing);
+                  }
+
+                  return Manager::self()->refreshFeature(QStringLiteral("resources/linking")).then([](const QFuture<bool> &operational) {
+                      return (operational.resultCount() > 0 && operational.result()) ? Everything : BasicInfo;
+                  });
+              })
+        .unwrap();
 }
 
 // clang-format off
 #define CREATE_GETTER(What)                                                    \
     QString Info::What() const                                                 \
     {                                                                          \
-        auto info = d->cache->getInfo(d->id);                                  \
-        return info ? info->What : QString();                                  \
+        const auto snapshot = d->cache->snapshot();                            \
+        const auto info = snapshot->activities.constFind(d->id);               \
+        return info != snapshot->activities.cend() ? info->What : QString();   \
     }
 // clang-format on
 
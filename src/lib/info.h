@@ -70,6 +70,19 @@ public:
     explicit Info(const QString &activity, QObject *parent = nullptr);
     ~Info() override;
 
+    /**
+     * @returns a shared instance of Info for the specified activity.
+     * All the callers that request the same activity get the same
+     * object for as long as somebody holds a reference to it, so that
+     * the models and views showing the same activities do not each
+     * create their own instances and connections.
+     * @note The returned object is owned by the shared pointer, it
+     * must not be deleted or reparented. It lives in the main thread,
+     * regardless of the thread it was requested from.
+     * @since 6.3
+     */
+    static std::shared_ptr<Info> shared(const QString &activity);
+
     /**
      * @return true if the activity represented by this object exists and is valid
      */
@@ -98,9 +111,20 @@ public:
 
     /**
      * @returns what info is provided by this instance of Info
+     * @note This method does not contact the service, it returns
+     * the last known state.
      */
     Availability availability() const;
 
+    /**
+     * @returns what info is provided by this instance of Info, after
+     * checking the current state with the service
+     * @note This QFuture is not thread-based, you can not call synchronous
+     * methods like waitForFinished, cancel, pause on it.
+     * @since 6.3
+     */
+    QFuture<Availability> availabilityFuture() const;
+
     /**
      * @returns the URI of this activity. The same URI is used by activities
      * KIO worker.
@@ -218,19 +242,8 @@ Q_SIGNALS:
 private:
     const std::unique_ptr<InfoPrivate> d;
 
-    Q_PRIVATE_SLOT(d, void activityStateChanged(const QString &, int))
-    Q_PRIVATE_SLOT(d, void added(const QString &))
-    Q_PRIVATE_SLOT(d, void removed(const QString &))
-    Q_PRIVATE_SLOT(d, void started(const QString &))
-    Q_PRIVATE_SLOT(d, void stopped(const QString &))
-    Q_PRIVATE_SLOT(d, void infoChanged(const QString &))
-    Q_PRIVATE_SLOT(d, void nameChanged(const QString &, const QString &))
-    Q_PRIVATE_SLOT(d, void descriptionChanged(const QString &, const QString &))
-    Q_PRIVATE_SLOT(d, void iconChanged(const QString &, const QString &))
-    Q_PRIVATE_SLOT(d, void setServiceStatus(Consumer::ServiceStatus))
-    Q_PRIVATE_SLOT(d, void setCurrentActivity(const QString &))
-
     friend class InfoPrivate;
+    friend class ActivitiesCache;
 };
 
 } // namespace KActivities
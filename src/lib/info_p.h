@@ -19,16 +19,16 @@ class InfoPrivate
 public:
     InfoPrivate(Info *info, const QString &activity);
 
-    void activityStateChanged(const QString &, int) const;
-
-    void added(const QString &) const;
-    void removed(const QString &) const;
-    void started(const QString &) const;
-    void stopped(const QString &) const;
-    void infoChanged(const QString &) const;
-    void nameChanged(const QString &, const QString &) const;
-    void descriptionChanged(const QString &, const QString &) const;
-    void iconChanged(const QString &, const QString &) const;
+    // These are called by the cache only for the activity
+    // this instance is subscribed to
+    void activityStateChanged(int state) const;
+
+    void added() const;
+    void removed() const;
+    void infoChanged() const;
+    void nameChanged(const QString &name) const;
+    void descriptionChanged(const QString &description) const;
+    void iconChanged(const QString &icon) const;
     void setServiceStatus(Consumer::ServiceStatus status) const;
     void setCurrentActivity(const QString &currentActivity);
 
@@ -11,11 +11,13 @@
 
 #include <QCoreApplication>
 #include <QDBusConnection>
-#include <QFutureWatcher>
-#include <QFutureWatcherBase>
+#include <QDBusConnectionInterface>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QMutexLocker>
+#include <QThread>
 
 #include "debug_p.h"
-#include "mainthreadexecutor_p.h"
 
 #include "common/dbus/common.h"
 #include "utils/continue_with.h"
@@ -28,53 +30,98 @@ Manager *Manager::s_instance = nullptr;
 
 Manager::Manager()
     : QObject()
-    , m_watcher(KAMD_DBUS_SERVICE, QDBusConnection::sessionBus())
+    , m_watcher(nullptr)
     , m_service(new KAMD_DBUS_CLASS_INTERFACE("/", Application, this))
     , m_activities(new KAMD_DBUS_CLASS_INTERFACE("Activities", Activities, this))
     , m_resources(new KAMD_DBUS_CLASS_INTERFACE("Resources", Resources, this))
     , m_resourcesLinking(new KAMD_DBUS_CLASS_INTERFACE("Resources/Linking", ResourcesLinking, this))
     , m_features(new KAMD_DBUS_CLASS_INTERFACE("Features", Features, this))
-    , m_serviceRunning(false)
+    , m_serviceState(ServiceState::Unknown)
 {
-    connect(&m_watcher, &QDBusServiceWatcher::serviceOwnerChanged, this, &Manager::serviceOwnerChanged);
+}
+
+void Manager::initialize()
+{
+    auto busInterface = QDBusConnection::sessionBus().interface();
 
-    if (isServiceRunning()) {
-        serviceOwnerChanged(KAMD_DBUS_SERVICE, QString(), KAMD_DBUS_SERVICE);
+    // We do not have a dbus connection at all
+    if (!busInterface) {
+        m_serviceState = ServiceState::NotRunning;
+        Q_EMIT serviceStatusChanged(false);
+        return;
     }
+
+    // The watcher is connected before we ask for the current owner,
+    // so that we do not miss the changes that happen in the meantime
+    m_watcher = new QDBusServiceWatcher(KAMD_DBUS_SERVICE, QDBusConnection::sessionBus(), QDBusServiceWatcher::WatchForOwnerChange, this);
+    connect(m_watcher, &QDBusServiceWatcher::serviceOwnerChanged, this, &Manager::serviceOwnerChanged);
+
+    auto ownerWatcher = new QDBusPendingCallWatcher(busInterface->asyncCall(QStringLiteral("NameHasOwner"), KAMD_DBUS_SERVICE), this);
+
+    connect(ownerWatcher, &QDBusPendingCallWatcher::finished, this, [this, ownerWatcher] {
+        ownerWatcher->deleteLater();
+
+        // The service watcher has already told us what we wanted to know
+        if (m_serviceState != ServiceState::Unknown) {
+            return;
+        }
+
+        const QDBusPendingReply<bool> reply = *ownerWatcher;
+
+        if (reply.isValid() && reply.value()) {
+            serviceOwnerChanged(KAMD_DBUS_SERVICE, QString(), KAMD_DBUS_SERVICE);
+            return;
+        }
+
+        // The listeners that are showing the data from the previous
+        // session need to know that the service is not there
+        m_serviceState = ServiceState::NotRunning;
+        Q_EMIT serviceStatusChanged(false);
+
+        bool disableAutolaunch = QCoreApplication::instance()->property("org.kde.KActivities.core.disableAutostart").toBool();
+
+        qCDebug(KAMD_CORELIB) << "Should we start the daemon?";
+        // start only if not disabled
+        if (!disableAutolaunch) {
+            qCDebug(KAMD_CORELIB) << "Starting the activity manager daemon";
+            QDBusConnection::sessionBus().interface()->asyncCall(QStringLiteral("StartServiceByName"), KAMD_DBUS_SERVICE, uint(0));
+        }
+    });
 }
 
 Manager *Manager::self()
 {
-    static std::mutex singleton;
-    std::lock_guard<std::mutex> singleton_lock(singleton);
-
-    if (!s_instance) {
-        runInMainThread([]() {
-            // check if the activity manager is already running
-            if (!Manager::isServiceRunning()) {
-                bool disableAutolaunch = QCoreApplication::instance()->property("org.kde.KActivities.core.disableAutostart").toBool();
-
-                qCDebug(KAMD_CORELIB) << "Should we start the daemon?";
-                // start only if not disabled and we have a dbus connection at all
-                if (!disableAutolaunch && QDBusConnection::sessionBus().interface()) {
-                    qCDebug(KAMD_CORELIB) << "Starting the activity manager daemon";
-                    auto busInterface = QDBusConnection::sessionBus().interface();
-                    busInterface->asyncCall(QStringLiteral("StartServiceByName"), KAMD_DBUS_SERVICE, uint(0));
-                }
-            }
-
-            // creating a new instance of the class
-            Manager::s_instance = new Manager();
-        });
-    }
+    static std::once_flag instantiated;
+
+    // The instance is created in the calling thread, and then handed over
+    // to the main thread. We do not wait for the main thread to do anything
+    // since it might be blocked waiting for us. The rest of the initialization
+    // (everything that needs the event loop) happens in the main thread
+    std::call_once(instantiated, [] {
+        const auto mainThread = QCoreApplication::instance()->thread();
+
+        auto manager = new Manager();
+        manager->moveToThread(mainThread);
+        Manager::s_instance = manager;
+
+        if (QThread::currentThread() == mainThread) {
+            manager->initialize();
+        } else {
+            QMetaObject::invokeMethod(manager, &Manager::initialize, Qt::QueuedConnection);
+        }
+    });
 
     return s_instance;
 }
 
+Manager::ServiceState Manager::serviceState() const
+{
+    return m_serviceState.load(std::memory_order_relaxed);
+}
+
 bool Manager::isServiceRunning()
 {
-    return (s_instance ? s_instance->m_serviceRunning : true) && QDBusConnection::sessionBus().interface()
-        && QDBusConnection::sessionBus().interface()->isServiceRegistered(KAMD_DBUS_SERVICE);
+    return self()->serviceState() != ServiceState::NotRunning;
 }
 
 void Manager::serviceOwnerChanged(const QString &serviceName, const QString &oldOwner, const QString &newOwner)
@@ -82,19 +129,28 @@ void Manager::serviceOwnerChanged(const QString &serviceName, const QString &old
     Q_UNUSED(oldOwner);
 
     if (serviceName == KAMD_DBUS_SERVICE) {
-        m_serviceRunning = !newOwner.isEmpty();
-        Q_EMIT serviceStatusChanged(m_serviceRunning);
+        const bool serviceRunning = !newOwner.isEmpty();
+        m_serviceState = serviceRunning ? ServiceState::Running : ServiceState::NotRunning;
+
+        // The version query is sent before anybody is notified that the
+        // service is running, so that it gets pipelined with the queries
+        // the listeners send
+        if (serviceRunning) {
+            m_serviceVersion = DBusFuture::fromReply(m_service->serviceVersion());
+        }
 
-        if (m_serviceRunning) {
+        Q_EMIT serviceStatusChanged(serviceRunning);
+
+        if (serviceRunning) {
             using namespace kamd::utils;
 
-            continue_with(DBusFuture::fromReply(m_service->serviceVersion()), [this](const std::optional<QString> &serviceVersion) {
+            continue_with(m_serviceVersion, [this](const std::optional<QString> &serviceVersion) {
                 // Test whether the service is older than the library.
                 // If it is, we need to end this
 
                 if (!serviceVersion.has_value()) {
                     qWarning() << "KActivities: FATAL ERROR: Failed to contact the activity manager daemon";
-                    m_serviceRunning = false;
+                    m_serviceState = ServiceState::NotRunning;
                     return;
                 }
 
@@ -119,10 +175,47 @@ void Manager::serviceOwnerChanged(const QString &serviceName, const QString &old
                     qFatal("KActivities: FATAL ERROR: The service is older than the library");
                 }
             });
+
+            loadFeatures();
+
+        } else {
+            QMutexLocker lock(&m_featuresMutex);
+            m_features.clear();
         }
     }
 }
 
+void Manager::loadFeatures()
+{
+    // Only the linking of resources is exposed by the library (through
+    // Info::availability). We are asking about it directly, the service
+    // modules do not need to list it among their features
+    refreshFeature(QStringLiteral("resources/linking"));
+}
+
+QFuture<bool> Manager::refreshFeature(const QString &feature)
+{
+    auto result = DBusFuture::fromReply(m_features->IsFeatureOperational(feature));
+
+    kamd::utils::continue_with(result, [this, feature](const std::optional<bool> &operational) {
+        QMutexLocker lock(&m_featuresMutex);
+        m_features[feature] = operational.value_or(false);
+    });
+
+    return result;
+}
+
+QFuture<QString> Manager::serviceVersion() const
+{
+    return m_serviceVersion;
+}
+
+bool Manager::isFeatureOperational(const QString &feature) const
+{
+    QMutexLocker lock(&m_featuresMutex);
+    return m_features.value(feature, false);
+}
+
 Service::Activities *Manager::activities()
 {
     return self()->m_activities;
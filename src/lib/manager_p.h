@@ -15,19 +15,40 @@
 #include "resources_interface.h"
 #include "resources_linking_interface.h"
 
+#include "plasma_activities_export.h"
+
 #include <QDBusServiceWatcher>
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+
+#include <atomic>
 
 namespace Service = org::kde::ActivityManager;
 
 namespace KActivities
 {
-class Manager : public QObject
+// Exported only when the autotests are built, this is not a public API
+class PLASMA_ACTIVITIES_TESTS_EXPORT Manager : public QObject
 {
     Q_OBJECT
 
 public:
     static Manager *self();
 
+    enum class ServiceState {
+        Unknown,
+        NotRunning,
+        Running,
+    };
+
+    // The state is tracked from the service watcher, after one initial
+    // asynchronous ownership query, so checking it does not go to the bus
+    ServiceState serviceState() const;
+
+    // Whether it makes sense to call the service. This is optimistic
+    // until the initial ownership query returns - calls to a service
+    // that is not there fail immediately anyway
     static bool isServiceRunning();
 
     static Service::Activities *activities();
@@ -35,6 +56,16 @@ public:
     static Service::ResourcesLinking *resourcesLinking();
     static Service::Features *features();
 
+    // The operational status of the service features is loaded
+    // asynchronously when the service starts, so that it can be
+    // checked without blocking
+    bool isFeatureOperational(const QString &feature) const;
+
+    // The version of the service, the query is sent as soon
+    // as the service is detected
+    QFuture<QString> serviceVersion() const;
+    QFuture<bool> refreshFeature(const QString &feature);
+
 public Q_SLOTS:
     void serviceOwnerChanged(const QString &serviceName, const QString &oldOwner, const QString &newOwner);
 
@@ -44,7 +75,10 @@ Q_SIGNALS:
 private:
     Manager();
 
-    QDBusServiceWatcher m_watcher;
+    void initialize();
+    void loadFeatures();
+
+    QDBusServiceWatcher *m_watcher;
 
     static Manager *s_instance;
 
@@ -53,7 +87,11 @@ private:
     Service::Resources *const m_resources;
     Service::ResourcesLinking *const m_resourcesLinking;
     Service::Features *const m_features;
-    bool m_serviceRunning;
+    std::atomic<ServiceState> m_serviceState;
+    QFuture<QString> m_serviceVersion;
+
+    mutable QMutex m_featuresMutex;
+    QHash<QString, bool> m_features;
 
     friend class ManagerInstantiator;
 };
@@ -7,9 +7,9 @@
 #ifndef UTILS_CONTINUE_WITH_H
 #define UTILS_CONTINUE_WITH_H
 
+#include <QCoreApplication>
 #include <QDebug>
 #include <QFuture>
-#include <QFutureWatcher>
 
 #include <optional>
 
@@ -34,7 +34,9 @@ inline void test_continuation(const QJSValue &continuation)
 template<typename _ReturnType>
 inline void pass_value(const QFuture<_ReturnType> &future, QJSValue continuation)
 {
-    auto result = continuation.call({future.result()});
+    // A call that failed or timed out has no result,
+    // the handler gets undefined in that case
+    auto result = continuation.call({future.resultCount() > 0 ? QJSValue(future.result()) : QJSValue(QJSValue::UndefinedValue)});
     if (result.isError()) {
         qWarning() << "Handler returned this error: " << result.toString();
     }
@@ -72,16 +74,23 @@ inline void pass_value(_Continuation &&continuation)
 } //^ namespace detail
 
 template<typename _ReturnType, typename _Continuation>
-inline void continue_with(const QFuture<_ReturnType> &future, _Continuation &&continuation)
+inline void continue_with(QFuture<_ReturnType> future, QObject *context, _Continuation &&continuation)
 {
     detail::test_continuation(continuation);
 
-    auto watcher = new QFutureWatcher<_ReturnType>();
-    QObject::connect(watcher, &QFutureWatcherBase::finished, [=]() mutable {
-        detail::pass_value(future, continuation);
+    // The continuation is kept in the state shared with the future, and
+    // released as soon as it has been invoked, there is no watcher object
+    // that needs to be deleted. It is invoked in the thread of the context,
+    // and dropped if the context is destroyed before the future finishes.
+    future.then(context, [continuation = std::forward<_Continuation>(continuation)](const QFuture<_ReturnType> &result) mutable {
+        detail::pass_value(result, continuation);
     });
+}
 
-    watcher->setFuture(future);
+template<typename _ReturnType, typename _Continuation>
+inline void continue_with(QFuture<_ReturnType> future, _Continuation &&continuation)
+{
+    continue_with(std::move(future), QCoreApplication::instance(), std::forward<_Continuation>(continuation));
 }
 
 } // namespace utils
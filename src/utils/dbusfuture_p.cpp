@@ -6,45 +6,79 @@
 
 #include "dbusfuture_p.h"
 
+#include <QCoreApplication>
+
+#include <algorithm>
+#include <atomic>
+
 namespace DBusFuture
 {
-namespace detail
-{ //_
+namespace
+{
+std::array<std::atomic<quint64>, LatencyHistogram::bucketCount> s_completed;
+std::array<std::atomic<quint64>, LatencyHistogram::bucketCount> s_timedOut;
+std::atomic<int> s_pendingCalls;
+} // namespace
 
-template<>
-void DBusCallFutureInterface<void>::callFinished()
+int LatencyHistogram::bucketFor(qint64 msec)
 {
-    deleteLater();
+    return std::upper_bound(bounds.cbegin(), bounds.cend(), msec) - bounds.cbegin();
+}
+
+LatencyHistogram latencyHistogram()
+{
+    LatencyHistogram result;
 
-    // qDebug() << "This is call end";
+    for (int bucket = 0; bucket < LatencyHistogram::bucketCount; ++bucket) {
+        result.completed[bucket] = s_completed[bucket].load(std::memory_order_relaxed);
+        result.timedOut[bucket] = s_timedOut[bucket].load(std::memory_order_relaxed);
+    }
 
-    this->reportFinished();
+    return result;
 }
 
-ValueFutureInterface<void>::ValueFutureInterface()
+int pendingCalls()
 {
+    return s_pendingCalls.load(std::memory_order_relaxed);
 }
 
-QFuture<void> ValueFutureInterface<void>::start()
-{
-    auto future = this->future();
+namespace detail
+{ //_
 
-    this->reportFinished();
+void recordLatency(qint64 msec, bool timedOut)
+{
+    auto &buckets = timedOut ? s_timedOut : s_completed;
+    buckets[LatencyHistogram::bucketFor(msec)].fetch_add(1, std::memory_order_relaxed);
+}
 
-    deleteLater();
+void addPendingCalls(int count)
+{
+    s_pendingCalls.fetch_add(count, std::memory_order_relaxed);
+}
 
-    return future;
+int defaultTimeout()
+{
+    // A stalled service should not keep the callers waiting for the
+    // default D-Bus timeout, which is 25 seconds
+    static const int timeout = [] {
+        const auto property = QCoreApplication::instance()->property("org.kde.KActivities.core.callTimeout");
+        return property.isValid() ? property.toInt() : 10000;
+    }();
+
+    return timeout;
 }
 
 } //^ namespace detail
 
 QFuture<void> fromVoid()
 {
-    using namespace detail;
+    QPromise<void> promise;
+    auto future = promise.future();
 
-    auto valueFutureInterface = new ValueFutureInterface<void>();
+    promise.start();
+    promise.finish();
 
-    return valueFutureInterface->start();
+    return future;
 }
 
 } // namespace DBusFuture
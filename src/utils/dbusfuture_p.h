@@ -8,134 +8,170 @@
 #define ACTIVITIES_DBUSFUTURE_P_H
 
 #include <QDBusAbstractInterface>
+#include <QDBusConnection>
+#include <QDBusMessage>
 #include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
-#include <QDBusServiceWatcher>
+#include <QElapsedTimer>
 #include <QFuture>
-#include <QFutureInterface>
-#include <QFutureWatcherBase>
+#include <QFutureWatcher>
+#include <QPromise>
 
-#include "debug_p.h"
+#include <array>
+#include <type_traits>
 
+// The non-template parts are in a static library which the library, the
+// QML plugin and the autotests link to, each of them counts the calls it
+// makes on its own. This is not a public API
 namespace DBusFuture
 {
+/**
+ * How long the calls made through DBusFuture took to finish,
+ * separately for the calls that got a reply and for the ones
+ * that ran out of time. The canceled calls are not counted.
+ */
+struct LatencyHistogram {
+    // The upper bounds of the buckets in milliseconds,
+    // the last bucket collects everything slower than that
+    static constexpr std::array<qint64, 7> bounds = {1, 4, 16, 64, 256, 1024, 4096};
+    static constexpr int bucketCount = bounds.size() + 1;
+
+    std::array<quint64, bucketCount> completed = {};
+    std::array<quint64, bucketCount> timedOut = {};
+
+    static int bucketFor(qint64 msec);
+};
+
+/**
+ * A snapshot of the latencies of the calls made so far
+ */
+LatencyHistogram latencyHistogram();
+
+/**
+ * The number of calls that are still waiting for their
+ * replies. The canceled calls are released immediately.
+ */
+int pendingCalls();
+
 namespace detail
 { //_
 
-template<typename _Result>
-class DBusCallFutureInterface : public QObject, public QFutureInterface<_Result>
-{
-public:
-    DBusCallFutureInterface(QDBusPendingReply<_Result> reply)
-        : reply(reply)
-        , replyWatcher(nullptr)
-    {
-    }
+void recordLatency(qint64 msec, bool timedOut);
 
-    ~DBusCallFutureInterface() override
-    {
-        delete replyWatcher;
-    }
+void addPendingCalls(int count);
 
-    void callFinished();
+// The timeout used when the caller did not specify one, can be changed
+// through the org.kde.KActivities.core.callTimeout application property
+int defaultTimeout();
 
-    QFuture<_Result> start()
+// The promise lives inside the watcher of the call, so that a call
+// costs a single object (apart from the state shared with the future)
+// which deletes itself as soon as the reply arrives. D-Bus always
+// replies, if nothing else, with a timeout error, so it never leaks.
+// If the future gets canceled, the object is deleted right away
+// instead of waiting for a reply nobody needs.
+template<typename _Result>
+class PendingReplyPromise : public QDBusPendingCallWatcher
+{
+public:
+    explicit PendingReplyPromise(const QDBusPendingCall &call)
+        : QDBusPendingCallWatcher(call)
     {
-        replyWatcher = new QDBusPendingCallWatcher(reply);
+        elapsed.start();
+        promise.start();
 
-        QObject::connect(replyWatcher, &QDBusPendingCallWatcher::finished, [this]() {
+        QObject::connect(this, &QDBusPendingCallWatcher::finished, [this] {
             callFinished();
         });
 
-        this->reportStarted();
-
-        if (reply.isFinished()) {
-            this->callFinished();
-        }
+        // Deleting the watcher drops the pending call,
+        // its reply will be ignored when it arrives
+        QObject::connect(&cancelWatcher, &QFutureWatcherBase::canceled, this, &QObject::deleteLater);
+        cancelWatcher.setFuture(promise.future());
 
-        return this->future();
+        addPendingCalls(1);
     }
 
-private:
-    QDBusPendingReply<_Result> reply;
-    QDBusPendingCallWatcher *replyWatcher;
-};
-
-template<typename _Result>
-void DBusCallFutureInterface<_Result>::callFinished()
-{
-    deleteLater();
-
-    if (!reply.isError()) {
-        this->reportResult(reply.value());
+    ~PendingReplyPromise() override
+    {
+        addPendingCalls(-1);
     }
 
-    this->reportFinished();
-}
-
-template<>
-void DBusCallFutureInterface<void>::callFinished();
-
-template<typename _Result>
-class ValueFutureInterface : public QObject, QFutureInterface<_Result>
-{
-public:
-    ValueFutureInterface(const _Result &value)
-        : value(value)
+    QFuture<_Result> future()
     {
+        return promise.future();
     }
 
-    QFuture<_Result> start()
+private:
+    void callFinished()
     {
-        auto future = this->future();
+        cancelWatcher.disconnect(this);
 
-        this->reportResult(value);
-        this->reportFinished();
+        if (promise.isCanceled()) {
+            deleteLater();
+            return;
+        }
 
-        deleteLater();
+        const auto errorType = error().type();
+        recordLatency(elapsed.elapsed(), errorType == QDBusError::Timeout || errorType == QDBusError::NoReply);
 
-        return future;
-    }
+        if constexpr (!std::is_void_v<_Result>) {
+            const QDBusPendingReply<_Result> reply = *this;
 
-private:
-    _Result value;
-};
+            if (!reply.isError()) {
+                promise.addResult(reply.value());
+            }
+        }
 
-template<>
-class ValueFutureInterface<void> : public QObject, QFutureInterface<void>
-{
-public:
-    ValueFutureInterface();
-
-    QFuture<void> start();
-    // {
-    //     auto future = this->future();
-    //     this->reportFinished();
-    //     deleteLater();
-    //     return future;
-    // }
+        promise.finish();
+
+        deleteLater();
+    }
+
+    QPromise<_Result> promise;
+    QFutureWatcher<_Result> cancelWatcher;
+    QElapsedTimer elapsed;
 };
 
 } //^ namespace detail
 
+/**
+ * Calls the method, and returns a future that finishes when the reply
+ * arrives. If there is no reply in the specified number of milliseconds
+ * (or the default timeout if it is negative), the future finishes
+ * without a result. Canceling the future releases the pending call.
+ */
 template<typename _Result, typename... Args>
-QFuture<_Result> asyncCall(QDBusAbstractInterface *interface, const QString &method, Args &&...args)
+QFuture<_Result> asyncCallWithTimeout(QDBusAbstractInterface *interface, int timeout, const QString &method, Args &&...args)
 {
     using namespace detail;
 
-    auto callFutureInterface = new DBusCallFutureInterface<_Result>(interface->asyncCall(method, std::forward<Args>(args)...));
+    auto message = QDBusMessage::createMethodCall(interface->service(), interface->path(), interface->interface(), method);
+    message.setArguments({QVariant(std::forward<Args>(args))...});
+
+    auto pendingReply = new PendingReplyPromise<_Result>(interface->connection().asyncCall(message, timeout < 0 ? defaultTimeout() : timeout));
 
-    return callFutureInterface->start();
+    return pendingReply->future();
+}
+
+template<typename _Result, typename... Args>
+QFuture<_Result> asyncCall(QDBusAbstractInterface *interface, const QString &method, Args &&...args)
+{
+    return asyncCallWithTimeout<_Result>(interface, -1, method, std::forward<Args>(args)...);
 }
 
 template<typename _Result>
 QFuture<_Result> fromValue(const _Result &value)
 {
-    using namespace detail;
+    // No need for anything to wait on, the future is ready immediately
+    QPromise<_Result> promise;
+    auto future = promise.future();
 
-    auto valueFutureInterface = new ValueFutureInterface<_Result>(value);
+    promise.start();
+    promise.addResult(value);
+    promise.finish();
 
-    return valueFutureInterface->start();
+    return future;
 }
 
 template<typename _Result>
@@ -143,9 +179,9 @@ QFuture<_Result> fromReply(const QDBusPendingReply<_Result> &reply)
 {
     using namespace detail;
 
-    auto callFutureInterface = new DBusCallFutureInterface<_Result>(reply);
+    auto pendingReply = new PendingReplyPromise<_Result>(reply);
 
-    return callFutureInterface->start();
+    return pendingReply->future();
 }
 
 QFuture<void> fromVoid();
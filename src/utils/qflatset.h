@@ -20,12 +20,22 @@ public:
     {
     }
 
+    explicit QFlatSet(LessThan lessThan)
+        : m_lessThan(lessThan)
+    {
+    }
+
+    const LessThan &lessThan() const
+    {
+        return m_lessThan;
+    }
+
     inline
         // QPair<typename QList<T>::iterator, bool> insert(const T &value)
         std::tuple<typename QList<T>::iterator, int, bool>
         insert(const T &value)
     {
-        auto lessThan = LessThan();
+        const auto &lessThan = m_lessThan;
         auto begin = this->begin();
         auto end = this->end();
 
@@ -52,6 +62,8 @@ public:
 
 private:
     QFlatSet(const QFlatSet &original); // = delete
+
+    LessThan m_lessThan;
 };
 
 } // namespace KActivities
@@ -0,0 +1,272 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef UTILS_TASK_H
+#define UTILS_TASK_H
+
+#include <QCoreApplication>
+#include <QFuture>
+#include <QObject>
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace kamd
+{
+namespace utils
+{
+namespace detail
+{ //_
+
+// Resumes the coroutine once the future is finished. The continuation
+// is attached to the future itself, so there is no watcher involved,
+// and the coroutine is resumed from the event loop of the main thread.
+// A canceled future resumes the coroutine as well, without a result.
+template<typename _Result>
+class FutureAwaiter
+{
+public:
+    explicit FutureAwaiter(QFuture<_Result> future)
+        : m_future(std::move(future))
+    {
+    }
+
+    bool await_ready() const
+    {
+        return m_future.isFinished();
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        auto context = QCoreApplication::instance();
+
+        m_future
+            .then(context,
+                  [handle](const QFuture<_Result> &) {
+                      handle.resume();
+                  })
+            .onCanceled(context, [handle] {
+                handle.resume();
+            });
+    }
+
+    auto await_resume() const
+    {
+        if constexpr (std::is_void_v<_Result>) {
+            return;
+        } else {
+            return m_future.resultCount() > 0 ? std::optional(m_future.result()) : std::nullopt;
+        }
+    }
+
+private:
+    QFuture<_Result> m_future;
+};
+
+template<typename _Result>
+class TaskPromiseResult
+{
+public:
+    void return_value(_Result value)
+    {
+        m_result = std::move(value);
+    }
+
+    _Result result()
+    {
+        return std::move(*m_result);
+    }
+
+private:
+    std::optional<_Result> m_result;
+};
+
+template<>
+class TaskPromiseResult<void>
+{
+public:
+    void return_void()
+    {
+    }
+
+    void result()
+    {
+    }
+};
+
+} //^ namespace detail
+
+/**
+ * A coroutine that can co_await QFutures (and other tasks) without
+ * blocking or spinning the event loop. It starts running immediately,
+ * and when it suspends, it is resumed from the event loop when the
+ * awaited future finishes. Awaiting a QFuture<T> gives std::optional<T>
+ * which is empty if the future finished without a result.
+ *
+ * Only to be used in the main thread. The task needs to outlive the
+ * coroutine, destroying it while the coroutine is suspended is an error.
+ */
+template<typename _Result = void>
+class Task
+{
+public:
+    class promise_type : public detail::TaskPromiseResult<_Result>
+    {
+    public:
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        auto final_suspend() noexcept
+        {
+            // When finished, we continue with whoever was awaiting us
+            struct FinalAwaiter {
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                {
+                    const auto continuation = handle.promise().m_continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept
+                {
+                }
+            };
+
+            return FinalAwaiter();
+        }
+
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+
+        template<typename _FutureResult>
+        detail::FutureAwaiter<_FutureResult> await_transform(QFuture<_FutureResult> future)
+        {
+            return detail::FutureAwaiter<_FutureResult>(std::move(future));
+        }
+
+        template<typename _Awaitable>
+        _Awaitable &&await_transform(_Awaitable &&awaitable)
+        {
+            return std::forward<_Awaitable>(awaitable);
+        }
+
+    private:
+        std::coroutine_handle<> m_continuation;
+        friend class Task;
+    };
+
+    Task(Task &&other) noexcept
+        : m_handle(std::exchange(other.m_handle, nullptr))
+    {
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+    Task &operator=(Task &&) = delete;
+
+    ~Task()
+    {
+        if (m_handle) {
+            Q_ASSERT_X(m_handle.done(), "Task", "The task was destroyed while its coroutine was suspended");
+            m_handle.destroy();
+        }
+    }
+
+    bool isFinished() const
+    {
+        return m_handle.done();
+    }
+
+    // Tasks can be awaited from other tasks
+    bool await_ready() const noexcept
+    {
+        return m_handle.done();
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().m_continuation = awaiting;
+    }
+
+    _Result await_resume()
+    {
+        return m_handle.promise().result();
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : m_handle(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+/**
+ * Suspends the coroutine until the condition is satisfied. The condition
+ * is checked immediately, and then each time the sender emits the signal.
+ */
+template<typename _Sender, typename _Signal, typename _Condition>
+auto when(_Sender *sender, _Signal signal, _Condition condition)
+{
+    class SignalAwaiter
+    {
+    public:
+        SignalAwaiter(_Sender *sender, _Signal signal, _Condition condition)
+            : m_sender(sender)
+            , m_signal(signal)
+            , m_condition(std::move(condition))
+        {
+        }
+
+        bool await_ready()
+        {
+            return m_condition();
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            m_connection = QObject::connect(m_sender, m_signal, m_sender, [this, handle] {
+                if (m_condition()) {
+                    QObject::disconnect(m_connection);
+                    handle.resume();
+                }
+            });
+        }
+
+        void await_resume() const
+        {
+        }
+
+    private:
+        _Sender *m_sender;
+        _Signal m_signal;
+        _Condition m_condition;
+        QMetaObject::Connection m_connection;
+    };
+
+    return SignalAwaiter(sender, signal, std::move(condition));
+}
+
+} // namespace utils
+} // namespace kamd
+
+#endif /* !UTILS_TASK_H */